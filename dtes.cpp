@@ -7,48 +7,36 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <map>
+#include <deque>
 #include <set>
 #include <span>
+#include <ranges>
+#include <array>
 #include <cctype>
 #include <optional>
 #include <memory>
+#include <memory_resource>
 #include <fstream>
+#include <bitset>
+#include <bit>
+#include <thread>
+#include <atomic>
+#include <iomanip>
+#include <chrono>
+#include <numeric>
+#include <cstring>
+#include <string_view>
+#include <charconv>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 using namespace std;
 
-void trim(string &s) {
-	s.erase(
-			s.begin(),
-			find_if(s.begin(), s.end(), [](char c) { return !isspace(c); })
-	);
-	s.erase(
-			find_if(s.rbegin(), s.rend(), [](char c) { return !isspace(c); }).base(),
-			s.end()
-	);
-}
-
-vector<string> list_of_strings(istream &is) {
-	if(is.peek() != '[') {
-		is.setstate(ios_base::failbit);
-		return vector<string>();
-	}
-	is.get();
-
-	string list;
-	if(!getline(is, list, ']')) return vector<string>();
-
-	istringstream ss(list);
-	vector<string> strings;
-	string elem;
-
-	while(getline(ss, elem, ',')) {
-		trim(elem);
-		if(!elem.empty()) strings.push_back(elem);
-	}
-
-	return strings;
-}
-
 template<typename It>
 void write_joined(ostream &os, It first, It last, string join = ", ") {
 	if(first == last) return;
@@ -76,7 +64,7 @@ string colon_sep_triple(const tuple<string, string, string> &tup) {
 }
 
 template<typename T>
-void asym_diff(set<T> &prior, set<T> &posterior, set<T> &additions, set<T> &removals) {
+void asym_diff(const set<T> &prior, const set<T> &posterior, set<T> &additions, set<T> &removals) {
 	additions = posterior;
 	for(auto &elem: prior) additions.erase(elem);
 	removals = prior;
@@ -84,12 +72,342 @@ void asym_diff(set<T> &prior, set<T> &posterior, set<T> &additions, set<T> &remo
 }
 
 template<typename T>
-void asym_diff(set<T> &prior, set<T> &posterior, set<T> &additions, set<T> &removals, set<T> &intersection) {
+void asym_diff(const set<T> &prior, const set<T> &posterior, set<T> &additions, set<T> &removals, set<T> &intersection) {
 	asym_diff(prior, posterior, additions, removals);
 	intersection = posterior;
 	for(auto &elem: additions) intersection.erase(elem);
 }
 
+// The binary world format: a magic number and version, a table of every
+// distinct string, then the same sections as the text format with strings
+// given as indices into the table and players in relations given as their
+// position in the players section. Numbers are in native byte order; the
+// format is meant for snapshots on one machine, not for interchange.
+const char BIN_MAGIC[8] = {'\x7f', 'D', 'T', 'E', 'S', 'B', 'I', 'N'};
+const uint32_t BIN_VERSION = 3;
+
+class Player;
+
+class BinWriter {
+	public:
+		string body;
+		unordered_map<string, uint32_t> string_ids;
+		vector<const string *> strings;
+		vector<uint32_t> player_ordinals;  // by Player::index
+
+		void u8(uint8_t v) { body.push_back(char(v)); }
+		void u32(uint32_t v) { body.append(reinterpret_cast<const char *>(&v), sizeof(v)); }
+		void i32(int32_t v) { u32(uint32_t(v)); }
+
+		void str(const string &s) {
+			auto [it, inserted] = string_ids.try_emplace(s, strings.size());
+			if(inserted) strings.push_back(&it->first);
+			u32(it->second);
+		}
+
+		template<typename It>
+		void strs(It first, It last) {
+			u32(distance(first, last));
+			for(; first != last; first++) str(*first);
+		}
+
+		void finish(ostream &os) const {
+			os.write(BIN_MAGIC, sizeof(BIN_MAGIC));
+			uint32_t header[2] = {BIN_VERSION, uint32_t(strings.size())};
+			os.write(reinterpret_cast<const char *>(header), sizeof(header));
+			for(const string *s: strings) {
+				uint32_t len = s->size();
+				os.write(reinterpret_cast<const char *>(&len), sizeof(len));
+				os.write(s->data(), len);
+			}
+			os.write(body.data(), body.size());
+		}
+};
+
+class BinReader {
+	public:
+		const char *at, *end;
+		vector<string_view> strings;
+		vector<Player *> players;  // by position in the players section
+		bool ok = true;
+
+		BinReader(string_view data) : at(data.data()), end(data.data() + data.size()) {
+			char magic[sizeof(BIN_MAGIC)];
+			if(!take(magic, sizeof(magic)) || memcmp(magic, BIN_MAGIC, sizeof(magic))) {
+				ok = false;
+				return;
+			}
+			if(u32() != BIN_VERSION) {
+				cerr << "binary world has an unsupported version" << endl;
+				ok = false;
+				return;
+			}
+			uint32_t count = u32();
+			for(uint32_t i = 0; ok && i < count; i++) {
+				uint32_t len = u32();
+				if(size_t(end - at) < len) {
+					ok = false;
+					break;
+				}
+				strings.emplace_back(at, len);
+				at += len;
+			}
+		}
+
+		uint8_t u8() {
+			uint8_t v = 0;
+			take(&v, sizeof(v));
+			return v;
+		}
+
+		uint32_t u32() {
+			uint32_t v = 0;
+			take(&v, sizeof(v));
+			return v;
+		}
+
+		int32_t i32() { return int32_t(u32()); }
+
+		string str() {
+			uint32_t id = u32();
+			if(id >= strings.size()) {
+				ok = false;
+				return string();
+			}
+			return string(strings[id]);
+		}
+
+		template<typename C>
+		void strs(C &into) {
+			uint32_t count = u32();
+			for(uint32_t i = 0; ok && i < count; i++) into.insert(into.end(), str());
+		}
+
+		Player *player() {
+			uint32_t ord = u32();
+			if(ord >= players.size()) {
+				ok = false;
+				return nullptr;
+			}
+			return players[ord];
+		}
+
+	private:
+		bool take(void *into, size_t len) {
+			if(!ok || size_t(end - at) < len) {
+				ok = false;
+				return false;
+			}
+			memcpy(into, at, len);
+			at += len;
+			return true;
+		}
+};
+
+// The whole of an input: mapped into memory when it is a regular file, and
+// read into a buffer otherwise (such as from a pipe).
+class InputBuffer {
+	public:
+		InputBuffer(int fd, istream &is) {
+			struct stat st;
+			if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+				void *mem = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if(mem != MAP_FAILED) {
+					mapped = mem;
+					data = string_view(static_cast<const char *>(mem), st.st_size);
+					return;
+				}
+			}
+			buffer.assign(istreambuf_iterator<char>(is), istreambuf_iterator<char>());
+			data = buffer;
+		}
+
+		InputBuffer(const InputBuffer &) = delete;
+		InputBuffer &operator=(const InputBuffer &) = delete;
+
+		~InputBuffer() {
+			if(mapped) munmap(mapped, data.size());
+		}
+
+		string_view view() const { return data; }
+
+	private:
+		void *mapped = nullptr;
+		string buffer;
+		string_view data;
+};
+
+// Reads the text format from a buffer, handing out views into it rather than
+// copies. Problems are reported with the line and column where they were
+// found; a warning lets the read carry on, while an error stops it (ok
+// becomes false) and callers unwind by checking ok.
+class TextReader {
+	public:
+		bool ok = true;
+
+		TextReader(string_view text) : text(text) {}
+
+		bool at_end() const { return pos >= text.size(); }
+		char peek() const { return at_end() ? '\0' : text[pos]; }
+		size_t mark() const { return pos; }
+		// What was read since a mark
+		string_view view(size_t at) const { return text.substr(at, pos - at); }
+		// Goes back to a mark
+		void seek(size_t at) { pos = at; }
+
+		bool eat(char c) {
+			if(at_end() || text[pos] != c) return false;
+			pos++;
+			return true;
+		}
+
+		void skip_ws() {
+			while(!at_end() && isspace(static_cast<unsigned char>(text[pos]))) pos++;
+		}
+
+		// The next run of non-space characters, or "" at the end
+		string_view word() {
+			skip_ws();
+			size_t start = pos;
+			while(!at_end() && !isspace(static_cast<unsigned char>(text[pos]))) pos++;
+			return text.substr(start, pos - start);
+		}
+
+		// The rest of the current line, without its newline
+		string_view line() {
+			size_t end = text.find('\n', pos);
+			if(end == string_view::npos) end = text.size();
+			string_view result = text.substr(pos, end - pos);
+			pos = min(end + 1, text.size());
+			return result;
+		}
+
+		// Everything up to the next delim, which is consumed but not returned
+		string_view until(char delim) {
+			size_t end = text.find(delim, pos);
+			if(end == string_view::npos) {
+				error(string("expected '") + delim + "'");
+				return string_view();
+			}
+			string_view result = text.substr(pos, end - pos);
+			pos = end + 1;
+			return result;
+		}
+
+		// A number, if one comes next; if not, nothing is consumed
+		optional<int> integer() {
+			skip_ws();
+			size_t start = pos;
+			if(peek() == '+' || peek() == '-') pos++;
+			while(!at_end() && isdigit(static_cast<unsigned char>(text[pos]))) pos++;
+			int value;
+			const char *first = text.data() + start + (start < text.size() && text[start] == '+');
+			if(from_chars(first, text.data() + pos, value).ec != errc()) {
+				pos = start;
+				return optional<int>();
+			}
+			return value;
+		}
+
+		// Passes over whatever comes next: a braced block, a list, or a
+		// word, which stops short of a '}' so that the block around it
+		// still ends
+		void skip_value() {
+			skip_ws();
+			if(eat('[')) {
+				until(']');
+			} else if(eat('{')) {
+				for(size_t depth = 1; depth > 0; pos++) {
+					if(at_end()) return error("expected '}'");
+					if(text[pos] == '{') depth++;
+					else if(text[pos] == '}') depth--;
+				}
+			} else {
+				while(!at_end() && !isspace(static_cast<unsigned char>(text[pos])) && text[pos] != '}') pos++;
+			}
+		}
+
+		// Passes over a bracketed list without reading it; false, having
+		// consumed nothing, if a whole one doesn't come next
+		bool skip_list() {
+			if(peek() != '[') return false;
+			size_t end = text.find(']', pos);
+			if(end == string_view::npos) return false;
+			pos = end + 1;
+			return true;
+		}
+
+		// About how many entries the block whose '{' was just read has:
+		// the colons at its own level and outside any list, as each name
+		// is followed by one
+		size_t block_entries() const {
+			size_t entries = 0, depth = 1;
+			bool in_list = false;
+			for(size_t i = pos; i < text.size(); i++) {
+				switch(text[i]) {
+					case '{': depth++; break;
+					case '}': if(--depth == 0) return entries; break;
+					case '[': in_list = true; break;
+					case ']': in_list = false; break;
+					case ':': if(depth == 1 && !in_list) entries++; break;
+				}
+			}
+			return entries;
+		}
+
+		// A bracketed, comma-separated list, with each element trimmed and
+		// empty ones left out
+		vector<string_view> list() {
+			vector<string_view> elems;
+			if(!eat('[')) {
+				error("expected '['");
+				return elems;
+			}
+			string_view contents = until(']');
+			while(!contents.empty()) {
+				size_t comma = contents.find(',');
+				string_view elem = trim(contents.substr(0, comma));
+				if(!elem.empty()) elems.push_back(elem);
+				if(comma == string_view::npos) break;
+				contents.remove_prefix(comma + 1);
+			}
+			return elems;
+		}
+
+		void warn(const string &message, size_t at) const {
+			auto [line, column] = position(at);
+			cerr << line << ":" << column << ": " << message << endl;
+		}
+
+		void warn(const string &message) const { warn(message, pos); }
+
+		void error(const string &message, size_t at) {
+			if(ok) warn(message, at);
+			ok = false;
+		}
+
+		void error(const string &message) { error(message, pos); }
+
+		static string_view trim(string_view s) {
+			while(!s.empty() && isspace(static_cast<unsigned char>(s.front()))) s.remove_prefix(1);
+			while(!s.empty() && isspace(static_cast<unsigned char>(s.back()))) s.remove_suffix(1);
+			return s;
+		}
+
+	private:
+		string_view text;
+		size_t pos = 0;
+
+		pair<size_t, size_t> position(size_t at) const {
+			at = min(at, text.size());
+			size_t line = 1 + count(text.begin(), text.begin() + at, '\n');
+			size_t line_start = text.rfind('\n', at == 0 ? 0 : at - 1);
+			if(at == 0 || line_start == string_view::npos) line_start = 0;
+			else line_start++;
+			return {line, at - line_start + 1};
+		}
+};
+
 class World;
 
 template<typename T>
@@ -100,56 +418,85 @@ concept SerNoCtx = requires(T a, istream &is, ostream &os) {
 };
 
 template<typename T>
-concept SerCtx = requires(T a, const T ac, istream &is, ostream &os, World &w, const World &wc) {
+concept SerCtx = requires(T a, const T ac, TextReader &in, ostream &os, World &w, const World &wc) {
 	T();
-	a.read(is, w);
+	a.read(in, w);
 	ac.write(os, wc);
 };
 
 template<typename T>
 concept Ser = SerNoCtx<T> || SerCtx<T>;
 
+// For entities that know where their Namespace keeps them
+constexpr size_t NO_INDEX = SIZE_MAX;
+
+template<typename T>
+concept Indexed = requires(T &t) {
+	{ t.index } -> same_as<size_t &>;
+};
+
+// Entries are numbered densely in the order they were added, and kept in
+// that order in one vector, so an Indexed entry's name is found by its
+// index. Entries are only added while the Namespace is read, so pointers
+// to them stay good once it has been. Small Namespaces, like an event's
+// needs, are searched by name directly rather than through a hash table.
+// Iteration is in order of name.
 template<SerCtx T>
 class Namespace {
 	public:
-		map<string, T> forward;
-		map<const T *, string> inverse;
+		using Entry = pair<string, T>;  // the name is not to be changed
 
 		Namespace<T> &set(const string &key, T &&value) {
-			if(forward.contains(key)) {
-				inverse.erase(&forward.at(key));
+			// Assigning over an existing entry keeps its address
+			auto [id, added] = claim(key);
+			if(added) {
+				entries.emplace_back(key, move(value));
+				place(id);
+			} else {
+				entries[id].second = move(value);
 			}
-			forward.insert_or_assign(move(key), move(value));
-			inverse.insert({&forward.at(key), key});
+			if constexpr(Indexed<T>) entries[id].second.index = id;
 			return *this;
 		}
 
 		void clear() {
-			// In this order; clearing forward dangles inverse's pointers
-			inverse.clear();
-			forward.clear();
+			entries.clear();
+			slots.clear();
+			order.clear();
 		}
 
-		size_t size() { return forward.size(); }
+		size_t size() const { return entries.size(); }
 
-		T *get(const string &key) {
-			if(forward.contains(key)) return &forward.at(key);
-			return nullptr;
+		T *get(string_view key) {
+			optional<size_t> id = find(key);
+			return id ? &entries[*id].second : nullptr;
 		}
 
-		const T* get(const string &key) const {
-			if(forward.contains(key)) return &forward.at(key);
-			return nullptr;
+		const T* get(string_view key) const {
+			optional<size_t> id = find(key);
+			return id ? &entries[*id].second : nullptr;
+		}
+
+		const string &get_name(const T *v) const requires Indexed<T> {
+			static const string none;
+			if(!v || v->index >= entries.size() || &entries[v->index].second != v) return none;
+			return entries[v->index].first;
 		}
 
-		string get_name(const T *v) const {
-			if(inverse.contains(v)) return inverse.at(v);
-			return string();
+		// Where key comes in order of name, if it is here
+		optional<size_t> rank(string_view key) const {
+			auto it = lower_bound(order.begin(), order.end(), key, [this](size_t id, string_view k) { return entries[id].first < k; });
+			if(it == order.end() || entries[*it].first != key) return optional<size_t>();
+			return it - order.begin();
 		}
 
+		// The entries as (name, value) pairs, in order of name
+		auto by_name() { return order | views::transform([this](size_t id) -> Entry & { return entries[id]; }); }
+		auto by_name() const { return order | views::transform([this](size_t id) -> const Entry & { return entries[id]; }); }
+
 		ostream &write(ostream &os, const World &w, string indent = "  ", string end = "") const {
 			os << "{" << endl;
-			for(auto const &[id, elem]: forward) {
+			for(auto const &[id, elem]: by_name()) {
 				os << indent << id << ": ";
 				elem.write(os, w);
 				os << endl;
@@ -158,27 +505,121 @@ class Namespace {
 			return os;
 		}
 
-		istream &read(istream &is, World &w) {
-			string temp;
-			if(!(is >> temp)) return is;
-			if(temp != "{") {
-				is.setstate(ios_base::failbit);
-				return is;
+		void write_bin(BinWriter &out, const World &w) const {
+			out.u32(entries.size());
+			for(auto const &[id, elem]: by_name()) {
+				out.str(id);
+				elem.write_bin(out, w);
 			}
+		}
+
+		void read_bin(BinReader &in, World &w) {
 			clear();
-			while(true) {
-				is >> ws;
-				if(is.peek() == '}') {
-					is.get();
-					break;
-				}
-				getline(is, temp, ':');
-				is >> ws;
+			uint32_t count = in.u32();
+			entries.reserve(count);
+			for(uint32_t i = 0; in.ok && i < count; i++) {
+				string id = in.str();
 				T value;
-				value.read(is, w);
-				set(temp, move(value));
+				value.read_bin(in, w);
+				set(id, move(value));
+			}
+		}
+
+		void read(TextReader &in, World &w) {
+			if(in.word() != "{") return in.error("expected '{'");
+			clear();
+			// Room for every entry up front, as growing would move them all
+			entries.reserve(in.block_entries());
+			order.reserve(entries.capacity());
+			bool sorted = true;
+			while(in.ok) {
+				in.skip_ws();
+				if(in.eat('}')) break;
+				if(in.at_end()) return in.error("expected '}'");
+				string_view key = in.until(':');
+				in.skip_ws();
+				// Read in place; entries can be large, and moving them costs
+				auto [id, added] = claim(key);
+				if(added) {
+					// Names written by cat come in order, so sort only if not
+					if(!order.empty() && entries[order.back()].first > key) sorted = false;
+					order.push_back(id);
+					entries.emplace_back(piecewise_construct, forward_as_tuple(key), forward_as_tuple());
+				} else {
+					entries[id].second = T();
+				}
+				T &value = entries[id].second;
+				value.read(in, w);
+				if constexpr(Indexed<T>) value.index = id;
+			}
+			if(!sorted) sort(order.begin(), order.end(), [this](size_t a, size_t b) { return entries[a].first < entries[b].first; });
+		}
+
+	private:
+		// Up to this many entries, find looks through them all
+		static constexpr size_t FEW = 8;
+
+		vector<Entry> entries;  // by index
+		// Once there are more than FEW entries, an open-addressed table of
+		// (hash of name, index), at most half full. The hashes are kept so
+		// that growing it never has to look at the names again.
+		vector<pair<size_t, size_t>> slots;
+		vector<size_t> order;  // indexes in order of name
+
+		// The slot that holds key, or the empty one where it would go
+		size_t probe(size_t h, string_view key) const {
+			size_t mask = slots.size() - 1, i = h & mask;
+			while(slots[i].second != NO_INDEX && !(slots[i].first == h && entries[slots[i].second].first == key))
+				i = (i + 1) & mask;
+			return i;
+		}
+
+		optional<size_t> find(string_view key) const {
+			if(entries.size() <= FEW) {
+				for(size_t id = 0; id < entries.size(); id++)
+					if(entries[id].first == key) return id;
+				return optional<size_t>();
+			}
+			size_t id = slots[probe(hash<string_view>()(key), key)].second;
+			return id == NO_INDEX ? optional<size_t>() : make_optional(id);
+		}
+
+		// The index of key, and whether it is new, in which case the
+		// caller is to add its entry next
+		pair<size_t, bool> claim(string_view key) {
+			if(entries.size() < FEW) {
+				optional<size_t> id = find(key);
+				return {id.value_or(entries.size()), !id};
+			}
+			if(slots.size() < 2 * (entries.size() + 1)) grow();
+			size_t h = hash<string_view>()(key), i = probe(h, key);
+			if(slots[i].second != NO_INDEX) return {slots[i].second, false};
+			slots[i] = {h, entries.size()};
+			return {entries.size(), true};
+		}
+
+		void grow() {
+			vector<pair<size_t, size_t>> old(max(2 * slots.size(), bit_ceil(4 * FEW)), {0, NO_INDEX});
+			swap(old, slots);
+			auto put = [this](size_t h, size_t id) {
+				size_t mask = slots.size() - 1, i = h & mask;
+				while(slots[i].second != NO_INDEX) i = (i + 1) & mask;
+				slots[i] = {h, id};
+			};
+			if(old.empty()) {
+				for(size_t id = 0; id < entries.size(); id++)
+					put(hash<string_view>()(entries[id].first), id);
+			} else {
+				for(auto [h, id]: old)
+					if(id != NO_INDEX) put(h, id);
 			}
-			return is;
+		}
+
+		// Puts a new index into order where its name belongs
+		void place(size_t id) {
+			const string &name = entries[id].first;
+			auto it = upper_bound(order.begin(), order.end(), name, [this](const string &n, size_t other) { return n < entries[other].first; });
+			order.insert(it, id);
 		}
 };
 
@@ -189,6 +630,7 @@ class Pronouns {
 		string possessive;
 		string reflexive;
 		string tense;
+		size_t index = NO_INDEX;  // in World::pronouns
 
 		enum class Part { subject, object, possessive, reflexive };
 
@@ -202,30 +644,118 @@ class Pronouns {
 			return os;
 		}
 
-		friend istream &operator>>(istream &is, Pronouns &pro) {
-			is >> pro.subject >> pro.object >> pro.possessive >> pro.reflexive >> pro.tense;
-			return is;
-		}
-
 		ostream &write(ostream &os, const World &w) const {
 			os << *this;
 			return os;
 		}
 
-		istream &read(istream &is, World &w) {
-			is >> *this;
-			return is;
+		void read(TextReader &in, World &w) {
+			for(string *s: {&subject, &object, &possessive, &reflexive, &tense}) {
+				*s = in.word();
+				if(s->empty()) return in.error("expected five pronoun forms");
+			}
+		}
+
+		void write_bin(BinWriter &out, const World &w) const {
+			for(const string *s: {&subject, &object, &possessive, &reflexive, &tense}) out.str(*s);
+		}
+
+		void read_bin(BinReader &in, World &w) {
+			for(string *s: {&subject, &object, &possessive, &reflexive, &tense}) *s = in.str();
 		}
 
-		string get_part(Part p) const {
+		const string &get_part(Part p) const {
+			static const string unknown("???");
 			switch(p) {
 				case Part::subject: return subject;
 				case Part::object: return object;
 				case Part::possessive: return possessive;
 				case Part::reflexive: return reflexive;
 			}
-			return string("???");
+			return unknown;
+		}
+};
+
+// Attribute names are interned world-wide when the world is read, so that
+// matching can test a fixed-width mask instead of comparing strings. Ids past
+// the width of the mask still work, but fall back to the string sets.
+const size_t ATTR_BITS = 256;
+using AttrMask = bitset<ATTR_BITS>;
+
+class Symbols {
+	public:
+		unordered_map<string, size_t> ids;
+		vector<string> names;
+
+		size_t intern(const string &s) {
+			auto [it, inserted] = ids.try_emplace(s, names.size());
+			if(inserted) names.push_back(s);
+			return it->second;
+		}
+
+		void clear() {
+			ids.clear();
+			names.clear();
+		}
+};
+
+class Relation;
+
+// The net changes made to players, the world and relations while effects
+// are applied, as recorded by the mutators (which only call in when
+// something actually changed). The first record of an attribute, property
+// or edge remembers how it was before; later ones update how it is now.
+class ChangeLog {
+	public:
+		void attr(Player *p, const string &name, bool present) {
+			auto [it, fresh] = attrs.try_emplace({p, name}, !present, present);
+			if(!fresh) it->second.second = present;
+		}
+
+		void prop(Player *p, const string &key, const optional<string> &before, const optional<string> &after) {
+			auto [it, fresh] = props.try_emplace({p, key}, before, after);
+			if(!fresh) it->second.second = after;
+		}
+
+		void edge(const Relation *rel, Player *left, Player *right, bool present) {
+			auto [it, fresh] = edges.try_emplace({rel, left, right}, !present, present);
+			if(!fresh) it->second.second = present;
+		}
+
+		void clear() {
+			attrs.clear();
+			props.clear();
+			edges.clear();
+		}
+
+		// Records other's changes as if they were made after these
+		void merge(const ChangeLog &other) {
+			for(const auto &[key, change]: other.attrs) {
+				auto [it, fresh] = attrs.try_emplace(key, change);
+				if(!fresh) it->second.second = change.second;
+			}
+			for(const auto &[key, change]: other.props) {
+				auto [it, fresh] = props.try_emplace(key, change);
+				if(!fresh) it->second.second = change.second;
+			}
+			for(const auto &[key, change]: other.edges) {
+				auto [it, fresh] = edges.try_emplace(key, change);
+				if(!fresh) it->second.second = change.second;
+			}
 		}
+
+		// In the notation and order of the diff action, followed (unless
+		// with_world is false) by changes to the world's attributes and
+		// properties as <world>[+attr]
+		void write(ostream &os, const World &w, bool with_world = true) const;
+
+		// Applies one line of that notation; false if it makes no sense
+		static bool apply(World &w, string_view line);
+
+	private:
+		map<pair<Player *, string>, pair<bool, bool>> attrs;
+		map<pair<Player *, string>, pair<optional<string>, optional<string>>> props;
+		map<tuple<const Relation *, Player *, Player *>, pair<bool, bool>> edges;
 };
 
 class Player {
@@ -233,107 +763,564 @@ class Player {
 		string name;
 		const Pronouns *pro;
 		set<string> attrs;
-		map<string, string> props;
+		AttrMask attr_mask;  // bits of attrs, by World::attr_symbols id
+		map<string, string, less<>> props;
+		size_t index = NO_INDEX;  // in World::players, dense in the order read
 
 		Player() : name(), pro(nullptr) {}
 		Player(const string &name, Pronouns *pro) : name(name), pro(pro) {}
 
+		void insert_attr(const string &s, size_t id) {
+			attrs.insert(s);
+			if(id < ATTR_BITS) attr_mask.set(id);
+		}
+
+		void erase_attr(const string &s, size_t id) {
+			attrs.erase(s);
+			if(id < ATTR_BITS) attr_mask.reset(id);
+		}
+
+		void clear_attrs() {
+			attrs.clear();
+			attr_mask.reset();
+		}
+
 		ostream &write(ostream &os, const World &w) const;
-		istream &read(istream &is, World &w);
+		void read(TextReader &in, World &w);
+		void write_bin(BinWriter &out, const World &w) const;
+		void read_bin(BinReader &in, World &w);
 
 		void diff(Player *to, ostream &os, const World &w, const World &nw);
+		void diff(const Player &to, ostream &os, const string &me, const string &them) const;
 };
 
 class Relation {
 	public:
 		bool directional;
 		bool allow_reflex;
-		set<pair<Player *, Player *>> edges;
+		size_t index = NO_INDEX;  // in World::relations
+
+		// Edges are kept as a list of right-hand players for every left-hand
+		// player, indexed and sorted by Player::index. Worlds small enough
+		// to afford it also get a bit matrix, so contains() is a single test.
+		class Adjacency {
+			public:
+				Player *player = nullptr;
+				vector<Player *> out;
+		};
+		vector<Adjacency> adjacency;
+		vector<uint64_t> matrix;
+		size_t matrix_dim = 0;
+		size_t edge_count = 0;
+
+		static constexpr size_t MATRIX_MAX_PLAYERS = 1024;
 
-		void insert(Player *left, Player *right) {
+		void insert(Player *left, Player *right, ChangeLog *changes = nullptr) {
 			if(!allow_reflex && left == right) return;
-			edges.insert({left, right});
-			if(!directional)
-				edges.insert({right, left});
+			if(insert_edge(left, right) && changes)
+				changes->edge(this, left, right, true);
+			if(!directional && insert_edge(right, left) && changes)
+				changes->edge(this, right, left, true);
+		}
+
+		void erase(Player *left, Player *right, ChangeLog *changes = nullptr) {
+			if(erase_edge(left, right) && changes)
+				changes->edge(this, left, right, false);
+			if(!directional && erase_edge(right, left) && changes)
+				changes->edge(this, right, left, false);
+		}
+
+		bool contains(const Player *left, const Player *right) const {
+			if(left->index < matrix_dim && right->index < matrix_dim)
+				return matrix_bit(left->index, right->index);
+			const vector<Player *> &out = neighbours(left);
+			auto it = lower_bound(out.begin(), out.end(), right, by_index);
+			return it != out.end() && *it == right;
+		}
+
+		const vector<Player *> &neighbours(const Player *left) const {
+			static const vector<Player *> none;
+			if(left->index >= adjacency.size()) return none;
+			return adjacency[left->index].out;
 		}
 
-		void erase(Player *left, Player *right) {
-			edges.erase({left, right});
-			if(!directional)
-				edges.erase({right, left});
+		size_t size() const { return edge_count; }
+
+		template<typename F>
+		void for_each_edge(F f) const {
+			for(const Adjacency &adj: adjacency)
+				for(Player *right: adj.out) f(adj.player, right);
 		}
 
-		bool contains(Player *left, Player *right) const {
-			return edges.contains({left, right});
+		void use_matrix(size_t players) {
+			matrix_dim = players <= MATRIX_MAX_PLAYERS ? players : 0;
+			matrix.assign((matrix_dim * matrix_dim + 63) / 64, 0);
+			for_each_edge([this](Player *l, Player *r) {
+					if(l->index < matrix_dim && r->index < matrix_dim)
+						set_matrix_bit(l->index, r->index, true);
+			});
 		}
 
 		ostream &write(ostream &os, const World &w) const;
-		istream &read(istream &is, World &w);
+		void read(TextReader &in, World &w);
+		void write_bin(BinWriter &out, const World &w) const;
+		void read_bin(BinReader &in, World &w);
 
 		void diff(Relation *to, ostream &os, const World &w, const World &nw);
+		void diff(const Relation &to, ostream &os, const string &me, const string &them, const World &w, const World &nw) const;
+
+	private:
+		static bool by_index(const Player *a, const Player *b) { return a->index < b->index; }
+
+		bool matrix_bit(size_t l, size_t r) const {
+			size_t bit = l * matrix_dim + r;
+			return (matrix[bit / 64] >> (bit % 64)) & 1;
+		}
+
+		void set_matrix_bit(size_t l, size_t r, bool value) {
+			size_t bit = l * matrix_dim + r;
+			if(value) matrix[bit / 64] |= uint64_t(1) << (bit % 64);
+			else matrix[bit / 64] &= ~(uint64_t(1) << (bit % 64));
+		}
+
+		// These return whether the edge was new, or was there
+		bool insert_edge(Player *left, Player *right) {
+			if(left->index >= adjacency.size()) adjacency.resize(left->index + 1);
+			Adjacency &adj = adjacency[left->index];
+			adj.player = left;
+			auto it = lower_bound(adj.out.begin(), adj.out.end(), right, by_index);
+			if(it != adj.out.end() && *it == right) return false;
+			adj.out.insert(it, right);
+			edge_count++;
+			if(left->index < matrix_dim && right->index < matrix_dim)
+				set_matrix_bit(left->index, right->index, true);
+			return true;
+		}
+
+		bool erase_edge(Player *left, Player *right) {
+			if(left->index >= adjacency.size()) return false;
+			vector<Player *> &out = adjacency[left->index].out;
+			auto it = lower_bound(out.begin(), out.end(), right, by_index);
+			if(it == out.end() || *it != right) return false;
+			out.erase(it);
+			edge_count--;
+			if(left->index < matrix_dim && right->index < matrix_dim)
+				set_matrix_bit(left->index, right->index, false);
+			return true;
+		}
 };
 
-class Event {
+// The players, numbered by place: those still in the game first, then those
+// matching the world's retire spec. Rounds only look at the live places, so
+// retired players cost nothing from round to round. MatchCache moves a player
+// across when their match with the retire spec changes.
+class Roster {
 	public:
-		class Binding;
+		static constexpr uint32_t NO_PLACE = UINT32_MAX;
+
+		// players must be in name order
+		template<typename Retired>
+		void assign(const vector<Player *> &players, Retired retired) {
+			by_place.clear();
+			by_place.reserve(players.size());
+			places.assign(players.size(), NO_PLACE);
+			name_ranks.assign(players.size(), 0);
+			vector<Player *> out;
+			for(size_t i = 0; i < players.size(); i++) {
+				name_ranks[players[i]->index] = i;
+				if(retired(players[i])) out.push_back(players[i]);
+				else by_place.push_back(players[i]);
+			}
+			live_count = by_place.size();
+			by_place.insert(by_place.end(), out.begin(), out.end());
+			for(size_t i = 0; i < by_place.size(); i++) places[by_place[i]->index] = i;
+		}
 
-		class ActorSpec {
+		size_t size() const { return by_place.size(); }
+		uint32_t place(const Player *p) const {
+			return p->index < places.size() ? places[p->index] : NO_PLACE;
+		}
+		Player *at(uint32_t place) const { return by_place[place]; }
+		uint32_t live_places() const { return live_count; }
+		bool is_live(const Player *p) const { return place(p) < live_count; }
+
+		// Moves p to the other side, swapping places with the last live
+		// player or the first retired one. Returns p's new place.
+		uint32_t cross(Player *p) {
+			uint32_t from = place(p), to = is_live(p) ? live_count - 1 : live_count;
+			swap(by_place[from], by_place[to]);
+			places[by_place[from]->index] = from;
+			places[p->index] = to;
+			if(to < live_count) live_count--;
+			else live_count++;
+			return to;
+		}
+
+		void sort_by_name(vector<Player *> &players) const {
+			sort(players.begin(), players.end(), [this](const Player *a, const Player *b) {
+					return name_ranks[a->index] < name_ranks[b->index];
+			});
+		}
+
+		// The live players, in name order
+		void live(vector<Player *> &into) const {
+			into.assign(by_place.begin(), by_place.begin() + live_count);
+			sort_by_name(into);
+		}
+
+	private:
+		vector<Player *> by_place;
+		vector<uint32_t> places;  // by Player::index
+		vector<uint32_t> name_ranks;  // by Player::index
+		uint32_t live_count = 0;
+};
+
+// The players that are still free to be bound in a round, in shuffled order.
+// Binding an event takes players tentatively; the caller then commits them or
+// rolls them back, which costs only as much as the players taken. Taken
+// players are marked rather than removed, and committed ones are swept out
+// (keeping the order) once they make up half of the list.
+class PlayerPool {
+	public:
+		static constexpr size_t NOT_IN_POOL = SIZE_MAX;
+
+		class iterator {
 			public:
-				set<string> attr_matches;
-				set<string> attr_neg_matches;
-				set<string> attr_adds;
-				set<string> attr_removes;
+				using value_type = Player *;
+				using difference_type = ptrdiff_t;
 
-				map<string, string> prop_matches;
-				map<string, string> prop_neg_matches;
-				map<string, string> prop_adds;
-				map<string, string> prop_removes;
+				iterator() = default;
+				iterator(const PlayerPool *pool, size_t at) : pool(pool), at(at) { skip(); }
 
-				void clear() {
-					attr_matches.clear();
-					attr_neg_matches.clear();
-					attr_adds.clear();
-					attr_removes.clear();
+				Player *operator*() const { return pool->order[at]; }
+				iterator &operator++() { at++; skip(); return *this; }
+				iterator operator++(int) { iterator it = *this; ++*this; return it; }
+				bool operator==(const iterator &other) const { return at == other.at; }
 
-					prop_matches.clear();
-					prop_neg_matches.clear();
-					prop_adds.clear();
-					prop_removes.clear();
-				}
+			private:
+				const PlayerPool *pool = nullptr;
+				size_t at = 0;
 
-				bool applies_to(const Player *ply) const {
-					for(const string &s: attr_matches) {
-						if(!ply->attrs.contains(s)) return false;
-					}
-					for(const string &s: attr_neg_matches) {
-						if(ply->attrs.contains(s)) return false;
-					}
-					for(const auto &[key, val]: prop_matches) {
-						if(val.empty()) {
-							if(!ply->props.contains(key)) return false;
-						} else {
-							if(!ply->props.contains(key) || ply->props.at(key) != val) return false;
-						}
-					}
-					for(const auto &[key, val]: prop_neg_matches) {
-						if(val.empty()) {
-							if(ply->props.contains(key)) return false;
-						} else {
-							if(ply->props.contains(key) && ply->props.at(key) == val) return false;
-						}
-					}
-					return true;
+				void skip() {
+					while(at < pool->order.size() && pool->taken[pool->roster->place(pool->order[at])]) at++;
 				}
+		};
 
-				void mutate_additions(Player *ply, Binding &b) const; 
-				void mutate_deletions(Player *ply, Binding &b) const; 
+		PlayerPool() = default;
+
+		// Players are looked up by their place in roster, so a pool of the
+		// live players costs nothing for the retired ones
+		void assign(const vector<Player *> &players, const Roster &r) {
+			roster = &r;
+			order = players;
+			uint32_t place_bound = 0;
+			for(Player *p: order) place_bound = max(place_bound, roster->place(p) + 1);
+			rank.assign(place_bound, NOT_IN_POOL);
+			taken.assign(place_bound, false);
+			for(size_t i = 0; i < order.size(); i++) rank[roster->place(order[i])] = i;
+			tentative.clear();
+			tentative.reserve(order.size());
+			committed = 0;
+		}
 
-				friend ostream &operator<<(ostream &os, const ActorSpec &as) {
-					os << "[";
-					vector<string> specs;
-					auto append_spec = back_inserter(specs);
-					copy(as.attr_matches.begin(), as.attr_matches.end(), append_spec);
-					transform(as.attr_neg_matches.begin(), as.attr_neg_matches.end(), append_spec, [](const string &s) {
+		iterator begin() const { return iterator(this, 0); }
+		iterator end() const { return iterator(this, order.size()); }
+
+		size_t size() const { return order.size() - committed - tentative.size(); }
+		bool empty() const { return size() == 0; }
+
+		// The position the player was shuffled into, for ordering; players
+		// not in the pool get NOT_IN_POOL.
+		size_t rank_of(const Player *p) const {
+			uint32_t place = roster->place(p);
+			return place < rank.size() ? rank[place] : NOT_IN_POOL;
+		}
+
+		bool is_free(const Player *p) const {
+			return rank_of(p) != NOT_IN_POOL && !taken[roster->place(p)];
+		}
+
+		void take(Player *p) {
+			taken[roster->place(p)] = true;
+			tentative.push_back(p);
+		}
+
+		void commit() {
+			committed += tentative.size();
+			tentative.clear();
+			if(committed > order.size() / 2) {
+				erase_if(order, [this](Player *p) { return taken[roster->place(p)]; });
+				committed = 0;
+			}
+		}
+
+		void rollback() {
+			for(Player *p: tentative) taken[roster->place(p)] = false;
+			tentative.clear();
+		}
+
+	private:
+		static inline const Roster no_roster;
+		const Roster *roster = &no_roster;
+		vector<Player *> order;
+		vector<size_t> rank;  // by place
+		vector<bool> taken;  // by place
+		vector<Player *> tentative;
+		size_t committed = 0;
+};
+
+void write_json_string(ostream &os, const string &s) {
+	os << '"';
+	for(char c: s) {
+		if(c == '"' || c == '\\') os << '\\' << c;
+		else if(c == '\n') os << "\\n";
+		else if(c == '\r') os << "\\r";
+		else if(c == '\t') os << "\\t";
+		else if(static_cast<unsigned char>(c) < 0x20) {
+			// Other control characters have no short escape
+			static const char hex[] = "0123456789abcdef";
+			os << "\\u00" << hex[c >> 4] << hex[c & 0xf];
+		} else os << c;
+	}
+	os << '"';
+}
+
+// Heap allocations made on this thread, so that bench and --stats can show
+// how much each phase of a round allocates. Every form of operator new is
+// replaced to count them, and every form of operator delete to match.
+thread_local uint64_t allocations = 0;
+
+static void *counted_alloc(size_t size, size_t align = __STDCPP_DEFAULT_NEW_ALIGNMENT__) noexcept {
+	allocations++;
+	size = max<size_t>(size, 1);
+	if(align <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) return malloc(size);
+	return aligned_alloc(align, (size + align - 1) / align * align);
+}
+
+static void *counted_alloc_or_throw(size_t size, size_t align = __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+	if(void *p = counted_alloc(size, align)) return p;
+	throw bad_alloc();
+}
+
+void *operator new(size_t size) { return counted_alloc_or_throw(size); }
+void *operator new[](size_t size) { return counted_alloc_or_throw(size); }
+void *operator new(size_t size, align_val_t align) { return counted_alloc_or_throw(size, size_t(align)); }
+void *operator new[](size_t size, align_val_t align) { return counted_alloc_or_throw(size, size_t(align)); }
+void *operator new(size_t size, const nothrow_t &) noexcept { return counted_alloc(size); }
+void *operator new[](size_t size, const nothrow_t &) noexcept { return counted_alloc(size); }
+void *operator new(size_t size, align_val_t align, const nothrow_t &) noexcept { return counted_alloc(size, size_t(align)); }
+void *operator new[](size_t size, align_val_t align, const nothrow_t &) noexcept { return counted_alloc(size, size_t(align)); }
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+void operator delete(void *p, align_val_t) noexcept { free(p); }
+void operator delete[](void *p, align_val_t) noexcept { free(p); }
+void operator delete(void *p, size_t, align_val_t) noexcept { free(p); }
+void operator delete[](void *p, size_t, align_val_t) noexcept { free(p); }
+void operator delete(void *p, const nothrow_t &) noexcept { free(p); }
+void operator delete[](void *p, const nothrow_t &) noexcept { free(p); }
+void operator delete(void *p, align_val_t, const nothrow_t &) noexcept { free(p); }
+void operator delete[](void *p, align_val_t, const nothrow_t &) noexcept { free(p); }
+
+// How one event fared while being bound, for --stats
+class EventStats {
+	public:
+		size_t drawn = 0;
+		size_t unlucky = 0;  // rejected by should_happen
+		size_t world_mismatch = 0;  // world_spec didn't apply
+		map<string, size_t> no_candidate;  // by need, when nobody could fill it
+		size_t combinations = 0;  // players tried in slots while matching relations
+		size_t unsatisfied = 0;  // no combination matched the relations
+		size_t bound = 0;
+		double bind_seconds = 0;
+
+		void merge(const EventStats &other) {
+			drawn += other.drawn;
+			unlucky += other.unlucky;
+			world_mismatch += other.world_mismatch;
+			for(const auto &[need, count]: other.no_candidate)
+				no_candidate[need] += count;
+			combinations += other.combinations;
+			unsatisfied += other.unsatisfied;
+			bound += other.bound;
+			bind_seconds += other.bind_seconds;
+		}
+
+		void write_json(ostream &os) const {
+			os << "{\"drawn\": " << drawn;
+			os << ", \"unlucky\": " << unlucky;
+			os << ", \"world_mismatch\": " << world_mismatch;
+			os << ", \"no_candidate\": {";
+			bool first = true;
+			for(const auto &[need, count]: no_candidate) {
+				if(!first) os << ", ";
+				first = false;
+				write_json_string(os, need);
+				os << ": " << count;
+			}
+			os << "}";
+			os << ", \"combinations\": " << combinations;
+			os << ", \"unsatisfied\": " << unsatisfied;
+			os << ", \"bound\": " << bound;
+			os << ", \"bind_s\": " << bind_seconds << "}";
+		}
+};
+
+// Counters over one or more rounds, by event name
+class RoundStats {
+	public:
+		size_t rounds = 0;
+		double bind_seconds = 0;
+		double render_seconds = 0;
+		double effects_seconds = 0;
+		uint64_t bind_allocs = 0, render_allocs = 0, effects_allocs = 0;
+		map<string, EventStats> events;
+
+		void merge(const RoundStats &other) {
+			rounds += other.rounds;
+			bind_seconds += other.bind_seconds;
+			render_seconds += other.render_seconds;
+			effects_seconds += other.effects_seconds;
+			bind_allocs += other.bind_allocs;
+			render_allocs += other.render_allocs;
+			effects_allocs += other.effects_allocs;
+			for(const auto &[name, es]: other.events)
+				events[name].merge(es);
+		}
+
+		void write_json(ostream &os) const {
+			os << "{\"rounds\": " << rounds;
+			os << ", \"bind_s\": " << bind_seconds;
+			os << ", \"render_s\": " << render_seconds;
+			os << ", \"effects_s\": " << effects_seconds;
+			os << ", \"bind_allocs\": " << bind_allocs;
+			os << ", \"render_allocs\": " << render_allocs;
+			os << ", \"effects_allocs\": " << effects_allocs;
+			os << ", \"events\": {";
+			bool first = true;
+			for(const auto &[name, es]: events) {
+				if(!first) os << ", ";
+				first = false;
+				write_json_string(os, name);
+				os << ": ";
+				es.write_json(os);
+			}
+			os << "}}" << endl;
+		}
+};
+
+class Event {
+	public:
+		class Binding;
+		class Message;
+
+		// A property value in an ActorSpec's add or remove list. It is
+		// compiled once when read; values without placeholders are kept as
+		// plain text and never rendered.
+		class Template {
+			public:
+				string source;
+				string text;  // the expansion, when plain()
+				unique_ptr<Message> program;
+
+				Template() = default;
+				Template(string_view src);
+
+				bool plain() const { return !program; }
+				string expand(Binding &b) const;
+
+				void write_bin(BinWriter &out) const;
+				void read_bin(BinReader &in);
+		};
+
+		static string colon_sep_template(const pair<const string, Template> &pair) {
+			return pair.first + ":" + pair.second.source;
+		}
+
+		class ActorSpec {
+			public:
+				set<string> attr_matches;
+				set<string> attr_neg_matches;
+				set<string> attr_adds;
+				set<string> attr_removes;
+
+				map<string, string> prop_matches;
+				map<string, string> prop_neg_matches;
+				map<string, Template> prop_adds;
+				map<string, Template> prop_removes;
+
+				// Filled by compile(); until then every attribute is
+				// checked by name.
+				AttrMask attr_must, attr_must_not, attr_add_mask, attr_remove_mask;
+				vector<string> attr_slow_matches, attr_slow_neg_matches;
+				// Set by MatchCache::build for the needs of events
+				optional<size_t> match_entry;
+
+				void compile(World &w);
+
+				void clear() {
+					attr_matches.clear();
+					attr_neg_matches.clear();
+					attr_adds.clear();
+					attr_removes.clear();
+
+					prop_matches.clear();
+					prop_neg_matches.clear();
+					prop_adds.clear();
+					prop_removes.clear();
+
+					attr_must.reset();
+					attr_must_not.reset();
+					attr_add_mask.reset();
+					attr_remove_mask.reset();
+					attr_slow_matches.clear();
+					attr_slow_neg_matches.clear();
+				}
+
+				bool applies_to(const Player *ply) const {
+					if((ply->attr_mask & attr_must) != attr_must) return false;
+					if((ply->attr_mask & attr_must_not).any()) return false;
+					for(const string &s: attr_slow_matches) {
+						if(!ply->attrs.contains(s)) return false;
+					}
+					for(const string &s: attr_slow_neg_matches) {
+						if(ply->attrs.contains(s)) return false;
+					}
+					for(const auto &[key, val]: prop_matches) {
+						if(val.empty()) {
+							if(!ply->props.contains(key)) return false;
+						} else {
+							if(!ply->props.contains(key) || ply->props.at(key) != val) return false;
+						}
+					}
+					for(const auto &[key, val]: prop_neg_matches) {
+						if(val.empty()) {
+							if(ply->props.contains(key)) return false;
+						} else {
+							if(ply->props.contains(key) && ply->props.at(key) == val) return false;
+						}
+					}
+					return true;
+				}
+
+				bool changes_anything() const {
+					return !(attr_adds.empty() && attr_removes.empty() && prop_adds.empty() && prop_removes.empty());
+				}
+
+				// Given values, prop_adds takes those expand_adds gave earlier
+				// rather than rendering them now
+				void mutate_additions(Player *ply, Binding &b, ChangeLog *changes = nullptr, const vector<string> *values = nullptr) const;
+				void mutate_deletions(Player *ply, Binding &b, ChangeLog *changes = nullptr) const;
+				vector<string> expand_adds(Binding &b) const;
+
+				friend ostream &operator<<(ostream &os, const ActorSpec &as) {
+					os << "[";
+					vector<string> specs;
+					auto append_spec = back_inserter(specs);
+					copy(as.attr_matches.begin(), as.attr_matches.end(), append_spec);
+					transform(as.attr_neg_matches.begin(), as.attr_neg_matches.end(), append_spec, [](const string &s) {
 							return "!" + s;
 					});
 					transform(as.prop_matches.begin(), as.prop_matches.end(), append_spec, colon_sep);
@@ -346,7 +1333,7 @@ class Event {
 						os << "+[";
 						specs.clear();
 						copy(as.attr_adds.begin(), as.attr_adds.end(), append_spec);
-						transform(as.prop_adds.begin(), as.prop_adds.end(), append_spec, colon_sep);
+						transform(as.prop_adds.begin(), as.prop_adds.end(), append_spec, colon_sep_template);
 						write_joined(os, specs.begin(), specs.end());
 						os << "]";
 					}
@@ -354,80 +1341,87 @@ class Event {
 						os << "-[";
 						specs.clear();
 						copy(as.attr_removes.begin(), as.attr_removes.end(), append_spec);
-						transform(as.prop_removes.begin(), as.prop_removes.end(), append_spec, colon_sep);
+						transform(as.prop_removes.begin(), as.prop_removes.end(), append_spec, colon_sep_template);
 						write_joined(os, specs.begin(), specs.end());
 						os << "]";
 					}
 					return os;
 				}
 
-				friend istream &operator>>(istream &is, ActorSpec &as) {
-					vector list = list_of_strings(is);
-					if(!is) return is;
-					as.attr_matches.clear();
-					as.attr_neg_matches.clear();
-					for(const string &s: list) {
-						if(s.at(0) == '!') {
-							auto colon = s.find(':');
-							if(colon != string::npos) {
-								as.prop_neg_matches.insert_or_assign(s.substr(1, colon - 1), s.substr(colon + 1));
-							} else {
-								as.attr_neg_matches.insert(s.substr(1));
-							}
+				ostream &write(ostream &os, const World &w) const {
+					os << *this;
+					return os;
+				}
+
+				void read(TextReader &in, World &w) {
+					attr_matches.clear();
+					attr_neg_matches.clear();
+					prop_matches.clear();
+					prop_neg_matches.clear();
+					for(string_view s: in.list()) {
+						bool neg = s.front() == '!';
+						if(neg) s.remove_prefix(1);
+						auto colon = s.find(':');
+						if(colon != string_view::npos) {
+							auto &props = neg ? prop_neg_matches : prop_matches;
+							props.insert_or_assign(string(s.substr(0, colon)), string(s.substr(colon + 1)));
 						} else {
-							auto colon = s.find(':');
-							if(colon != string::npos) {
-								as.prop_matches.insert_or_assign(s.substr(0, colon), s.substr(colon + 1));
-							} else {
-								as.attr_matches.insert(s);
-							}
+							(neg ? attr_neg_matches : attr_matches).insert(string(s));
 						}
 					}
 
-					as.attr_adds.clear();
-					as.attr_removes.clear();
-
-					is >> ws;
-					if(is.peek() == '+') {
-						is.get();
-						list = list_of_strings(is);
-						if(!is) return is;
-						for(const string &s: list) {
-							auto colon = s.find(':');
-							if(colon != string::npos) {
-								as.prop_adds.insert_or_assign(s.substr(0, colon), s.substr(colon + 1));
-							} else {
-								as.attr_adds.insert(s);
-							}
-						}
-						is >> ws;
+					attr_adds.clear();
+					attr_removes.clear();
+					prop_adds.clear();
+					prop_removes.clear();
+					in.skip_ws();
+					if(in.eat('+')) {
+						read_changes(in, attr_adds, prop_adds);
+						in.skip_ws();
 					}
-					if(is.peek() == '-') {
-						is.get();
-						list = list_of_strings(is);
-						if(!is) return is;
-						for(const string &s: list) {
-							auto colon = s.find(':');
-							if(colon != string::npos) {
-								as.prop_removes.insert_or_assign(s.substr(0, colon), s.substr(colon + 1));
-							} else {
-								as.attr_removes.insert(s);
-							}
-						}
-						is >> ws;
+					if(in.eat('-')) {
+						read_changes(in, attr_removes, prop_removes);
+						in.skip_ws();
 					}
-					return is;
+					compile(w);
 				}
 
-				ostream &write(ostream &os, const World &w) const {
-					os << *this;
-					return os;
+				// Passes over a spec as read would, without keeping it; false
+				// if it isn't whole, which read will then report
+				static bool skip(TextReader &in) {
+					if(!in.skip_list()) return false;
+					in.skip_ws();
+					for(char change: {'+', '-'}) {
+						if(!in.eat(change)) continue;
+						if(!in.skip_list()) return false;
+						in.skip_ws();
+					}
+					return true;
+				}
+
+				// Whether any property change is a template that names a
+				// need, and so has to be linked to one event's needs
+				bool has_templates() const {
+					for(const map<string, Template> *props: {&prop_adds, &prop_removes}) {
+						for(const auto &[_, value]: *props)
+							if(value.program) return true;
+					}
+					return false;
 				}
 
-				istream &read(istream &is, World &w) {
-					is >> *this;
-					return is;
+				static void read_changes(TextReader &in, set<string> &attrs, map<string, Template> &props) {
+					for(string_view s: in.list()) {
+						auto colon = s.find(':');
+						if(colon != string_view::npos) {
+							props.insert_or_assign(string(s.substr(0, colon)), Template(s.substr(colon + 1)));
+						} else {
+							attrs.insert(string(s));
+						}
+					}
 				}
+
+				void write_bin(BinWriter &out, const World &w) const;
+				void read_bin(BinReader &in, World &w);
 		};
 
 		class RelSpec {
@@ -438,19 +1432,54 @@ class Event {
 				set<Triple> adds;
 				set<Triple> removes;
 
+				// A triple as Event::link resolves it
+				class Link {
+					public:
+						size_t left;
+						Relation *rel;
+						size_t right;
+				};
+				vector<Link> match_links, neg_match_links, add_links, remove_links;
+
 				void clear() {
 					matches.clear();
 					neg_matches.clear();
 					adds.clear();
 					removes.clear();
+					match_links.clear();
+					neg_match_links.clear();
+					add_links.clear();
+					remove_links.clear();
 				}
 
 				bool empty() const {
 					return matches.empty() && neg_matches.empty();
 				}
 
-				bool satisfied(Binding &b, const World &w) const;
-				void mutate(Binding &b, World &w) const;
+				bool satisfied(const Binding &b) const;
+				void mutate(const Binding &b, ChangeLog *changes = nullptr) const;
+
+				void write_bin(BinWriter &out) const {
+					for(const set<Triple> *triples: {&matches, &neg_matches, &adds, &removes}) {
+						out.u32(triples->size());
+						for(const auto &[left, rel, right]: *triples) {
+							out.str(left);
+							out.str(rel);
+							out.str(right);
+						}
+					}
+				}
+
+				void read_bin(BinReader &in) {
+					clear();
+					for(set<Triple> *triples: {&matches, &neg_matches, &adds, &removes}) {
+						uint32_t count = in.u32();
+						for(uint32_t i = 0; in.ok && i < count; i++) {
+							string left = in.str(), rel = in.str(), right = in.str();
+							triples->insert(Triple(left, rel, right));
+						}
+					}
+				}
 
 				friend ostream &operator<<(ostream &os, const RelSpec &rs) {
 					os << "{ ";
@@ -471,777 +1500,1419 @@ class Event {
 					return os;
 				}
 
-				friend istream &operator>>(istream &is, RelSpec &rs) {
-					is >> ws;
-					if(is.peek() != '{') {
-						is.setstate(ios_base::failbit);
-						return is;
-					}
-					is.get();
-
-					rs.clear();
-					string elem;
-					while(is >> ws, is >> elem, elem != "}") {
-						if(elem.empty()) continue;
-						set<Triple> *mod = &rs.matches;
-						if(elem.at(0) == '!') {
-							mod = &rs.neg_matches;
-							elem = elem.substr(1);
-						} else if(elem.at(0) == '+') {
-							mod = &rs.adds;
-							elem = elem.substr(1);
-						} else if(elem.at(0) == '-') {
-							mod = &rs.removes;
-							elem = elem.substr(1);
+				void read(TextReader &in) {
+					in.skip_ws();
+					if(!in.eat('{')) return in.error("expected '{'");
+
+					clear();
+					while(in.ok) {
+						in.skip_ws();
+						size_t at = in.mark();
+						string_view elem = in.word();
+						if(elem == "}") break;
+						if(elem.empty()) return in.error("expected '}'");
+						set<Triple> *mod = &matches;
+						if(elem.front() == '!') {
+							mod = &neg_matches;
+							elem.remove_prefix(1);
+						} else if(elem.front() == '+') {
+							mod = &adds;
+							elem.remove_prefix(1);
+						} else if(elem.front() == '-') {
+							mod = &removes;
+							elem.remove_prefix(1);
 						}
 
-						istringstream parser(elem);
-						string left, rel, right;
-						if(!getline(parser, left, ':')) continue;
-						if(!getline(parser, rel, ':')) continue;
-						right.append(istreambuf_iterator<char>(parser), istreambuf_iterator<char>());
-						if(left.empty() || rel.empty() || right.empty()) continue;
-						mod->insert(Triple(left, rel, right));
+						auto first = elem.find(':');
+						auto second = first == string_view::npos ? first : elem.find(':', first + 1);
+						if(second == string_view::npos || first == 0 || second == first + 1 || second + 1 == elem.size()) {
+							in.warn("ignoring " + string(elem) + ", which isn't need:relation:need", at);
+							continue;
+						}
+						mod->insert(Triple(elem.substr(0, first), elem.substr(first + 1, second - first - 1), elem.substr(second + 1)));
 					}
-
-					return is;
 				}
 		};
 
-		class Renderer;
-
+		// The players bound to an event's needs, by slot: the needs in
+		// name order. Events rarely have many needs, so the players are
+		// usually held inline.
 		class Binding {
 			public:
 				const Event &event;
-				map<string, Player *> players;
 				Player *last_player = nullptr;
 
-				Binding(const Event &e, map<string, Player *> ply) : event(e), players(ply) {}
-				static optional<Binding> try_bind(const Event &, const World &, vector<Player *> &, bool = true);
+				// Players past the inline ones are kept in mem, which a copy
+				// keeps using
+				Binding(const Event &e, pmr::memory_resource *mem = pmr::get_default_resource()) : event(e), count(e.actors.size()), spilled(mem) {
+					if(count > INLINE_SLOTS) spilled.resize(count);
+				}
+				Binding(const Binding &b) : event(b.event), last_player(b.last_player), count(b.count), local(b.local), spilled(b.spilled, b.spilled.get_allocator()) {}
+				Binding(Binding &&) = default;
 
-				friend ostream &operator<<(ostream &os, Binding &b);
+				size_t size() const { return count; }
+				Player *&operator[](size_t slot) { return count > INLINE_SLOTS ? spilled[slot] : local[slot]; }
+				Player *operator[](size_t slot) const { return count > INLINE_SLOTS ? spilled[slot] : local[slot]; }
 
-				void list_refs(ostream &os) {
-					os << "[";
-					write_joined(os, players.begin(), players.end(), [](const auto &pair) {
-							return pair.first;
-					});
-					os << "]";
-				}
+				// On success the bound players are taken from the pool tentatively, for
+				// the caller to commit or roll back; on failure the pool is unchanged.
+				// The event's world spec is the caller's to check (see WorldGate).
+				// Scratch space, and the binding's spilled players, come from
+				// the memory resource.
+				static optional<Binding> try_bind(const Event &, const World &, PlayerPool &, bool = true, EventStats * = nullptr, pmr::memory_resource * = pmr::get_default_resource());
 
-				Player *last_player_or(optional<string> name) {
-					Player *ply = last_player;
-					if(name) {
-						if(players.contains(*name)) {
-							ply = players.at(*name);
-						} else {
-							cerr << "bad player ref to " << *name << ": not in ";
-							list_refs(cerr);
-							cerr << endl;
-							ply = nullptr;  // ensure usage fails
-						}
-					}
-					return ply;
-				}
+				friend ostream &operator<<(ostream &os, Binding &b);
 
-				void cause_effects(World &w);
+				void cause_effects(World &w, ChangeLog *changes = nullptr);
+
+				// cause_effects in two parts, so that a round's bindings can be
+				// applied together: first to the binding's own players, which no
+				// other binding shares, then in binding order to the world and
+				// relations. world_adds holds what the world spec's prop_adds
+				// rendered in between, as the players were then.
+				void cause_player_effects(ChangeLog *changes, vector<string> &world_adds);
+				void cause_world_effects(World &w, const vector<string> &world_adds, ChangeLog *changes);
+
+			private:
+				static constexpr size_t INLINE_SLOTS = 4;
+				size_t count;
+				array<Player *, INLINE_SLOTS> local{};
+				pmr::vector<Player *> spilled;
 		};
 
-		class Renderer {
+		// A message, or a property template, compiled into a flat program.
+		// Text lives in one arena that instructions refer to by span, and
+		// actors are numbered slots, each looked up once per rendering.
+		class Message {
 			public:
-				virtual ~Renderer() = default;
-				virtual void render(ostream &, Binding &) = 0;
-				virtual ostream &write(ostream &os, const World &w) = 0;
-		};
+				enum class Op : uint8_t { literal, player_ref, prop_ref, tense_choice, pronoun, possessive_particle };
+				// The slot of an instruction that names no actor: it refers to
+				// the last player mentioned
+				static constexpr uint32_t LAST_PLAYER = UINT32_MAX;
 
-		class render {  // XXX hacky
-			public:
-				class Literal : public Renderer {
+				class Span {
 					public:
-						string value;
-						Literal(string v) : value(v) {}
-
-						virtual void render(ostream &os, Binding &_) {
-							os << value;
-						}
-						virtual ostream &write(ostream &os, const World &_) {
-							os << value;
-							return os;
-						}
+						uint32_t offset = 0, length = 0;
 				};
 
-				class PlayerRef : public Renderer {
+				class Instr {
 					public:
-						string actor;
-						PlayerRef(string n) : actor(n) {}
-
-						virtual void render(ostream &os, Binding &b) {
-							if(b.players.contains(actor)) {
-								Player *a = b.players.at(actor);
-								if(a) {
-									os << a->name;
-									b.last_player = a;
-								}
-							} else {
-								cerr << "bad playerref to " << actor << ": not in ";
-								b.list_refs(cerr);
-								cerr << endl;
-							}
-						}
-						virtual ostream &write(ostream &os, const World &_) {
-							os << "$<" << actor << ">";
-							return os;
-						}
+						Op op;
+						Pronouns::Part part = Pronouns::Part::subject;
+						bool upcase = false;
+						uint32_t slot = LAST_PLAYER;
+						// A literal or property name in the arena; for a tense
+						// choice, the range of its entries in tenses
+						Span text{};
 				};
 
-				class PropRef : public Renderer {
-					public:
-						optional<string> actor;
-						string prop;
-						PropRef(optional<string> a, string p): actor(a), prop(p) {}
-
-						virtual void render(ostream &os, Binding &b) {
-							Player *ply = b.last_player_or(actor);
-							if(!ply) {
-								cerr << "propref has no actor--either it was used before any playerref or no player was bound to the named ref" << endl;
-								return;
-							}
-							b.last_player = ply;
-							if(ply->props.contains(prop)) {
-								os << ply->props.at(prop);
-							}
-						}
-						virtual ostream &write(ostream &os, const World &_) {
-							os << "$<";
-							if(actor) {
-								os << *actor;
-							}
-							os << "." << prop << ">";
-							return os;
-						}
-				};
+				string arena;
+				vector<Instr> code;
+				vector<pair<Span, Span>> tenses;  // tense, replacement
+				vector<string> slots;  // actor names
+				vector<size_t> binding_slots;  // for each slot, once linked
 
-				class TenseChoice : public Renderer {
-					public:
-						optional<string> actor;
-						map<string, string> tenses;
-						TenseChoice(optional<string> a, map<string, string> t) : actor(a), tenses(t) {}
-
-						virtual void render(ostream &os, Binding &b) {
-							Player *ply = b.last_player_or(actor);
-							if(!ply) {
-								cerr << "tensechoice has no actor--either it was used before any playerref or no player was bound to the named ref" << endl;
-								return;
-							}
-							if(!ply->pro) {
-								cerr << "player " << ply->name << " has no pronouns, can't pick a tense " << endl;
-								return;
-							}
-							string t = ply->pro->tense;
-							if(tenses.contains(t))
-								os << tenses.at(t);
-						}
-						virtual ostream &write(ostream &os, const World &_) {
-							os << "[";
-							if(actor) {
-								os << "(" << *actor << ")";
-							}
-							write_joined(os, tenses.begin(), tenses.end(), [](const auto &pair) {
-									const auto &[tense, repl] = pair;
-									return tense + "=" + repl;
-							}, "/");
-							os << "]";
-							return os;
-						}
-				};
+				// Points each slot at its need's place in a binding. A ref to a
+				// name that isn't one of e's needs becomes literal text, as it
+				// rendered before linking; the names of any such are returned.
+				vector<string> link(const Event &e);
 
-				class Pronoun : public Renderer {
-					public:
-						optional<string> actor;
-						Pronouns::Part part;
-						bool upcase;
-						Pronoun(optional<string> a, Pronouns::Part p, bool u) : actor(a), part(p), upcase(u) {}
-
-						virtual void render(ostream &os, Binding &b) {
-							Player *ply = b.last_player_or(actor);
-							if(!ply) {
-								cerr << "pronoun has no actor--either it was used before any playerref or no player was bound to the named ref" << endl;
-								return;
-							}
-							if(!ply->pro) {
-								cerr << "player " << ply->name << " has no pronouns, can't use one" << endl;
-								return;
-							}
-							string pro = ply->pro->get_part(part);
-							if(!pro.empty() && upcase) {
-								pro[0] = toupper(pro[0]);
-							}
-							os << pro;
-							b.last_player = ply;
-						}
-						virtual ostream &write(ostream &os, const World &_) {
-							os << "<";
-							if(actor) {
-								os << "(" << *actor << ")";
-							}
-							string p;
-							switch(part) {
-								case Pronouns::Part::subject: p = "s"; break;
-								case Pronouns::Part::object: p = "o"; break;
-								case Pronouns::Part::possessive: p = "p"; break;
-								case Pronouns::Part::reflexive: p = "r"; break;
-							}
-							if(upcase) {
-								p[0] = toupper(p[0]);
-							}
-							os << p << ">";
-							return os;
-						}
-				};
+				Message() = default;
+				Message(string_view source);
 
-				class PossessiveParticle : public Renderer {
-					public:
-						optional<string> actor;
-						PossessiveParticle(optional<string> a) : actor(a) {}
-
-						virtual void render(ostream &os, Binding &b) {
-							Player *ply = b.last_player_or(actor);
-							if(!ply) {
-								cerr << "possessiveparticle has no actor--either it was used before any playerref or no player was bound to the named red" << endl;
-								return;
-							}
-							if(!ply->name.empty() && tolower(ply->name.back()) == 's') {
-								os << "'";
-							} else {
-								os << "'s";
-							}
-						}
-						virtual ostream &write(ostream &os, const World &_) {
-							os << "<";
-							if(actor) {
-								os << "(" << *actor << ")";
-							}
-							os << "'s>";
-							return os;
-						}
-				};
+				bool empty() const { return code.empty(); }
+				bool literal() const {
+					return all_of(code.begin(), code.end(), [](const Instr &in) { return in.op == Op::literal; });
+				}
+				string_view view(Span s) const { return string_view(arena).substr(s.offset, s.length); }
+
+				// Appends the message, as it reads for b, to out (a string
+				// or pmr::string)
+				template<typename String>
+				void render(String &out, Binding &b) const;
+				// The source text, give or take spelling
+				ostream &write(ostream &os) const;
+				void write_bin(BinWriter &out) const;
+				void read_bin(BinReader &in);
+
+			private:
+				void write(ostream &os, const Instr &in) const;
+
+				Instr &emit(Op op) {
+					code.push_back(Instr{.op = op});
+					return code.back();
+				}
 
-				static optional<string> parse_maybe_paren_name(istringstream &ss) {
-					if(ss.peek() == '(') {
-						ss.get();
-						string name;
-						getline(ss, name, ')');
-						return make_optional(name);
-					}
-					return optional<string>();
-				}
-
-				static vector<unique_ptr<Renderer>> parse_message(const string &msg) {
-					istringstream ss(msg);
-					string literal;
-					vector<unique_ptr<Renderer>> result;
-
-					while(true) {
-						char c = ss.get();
-						if(ss.eof()) break;
-						switch(c) {
-							case '$': {
-								if(!literal.empty()) {
-									result.push_back(
-											unique_ptr<Renderer>(
-												new Literal(literal)
-											)
-									);
-									literal.clear();
-								}
-								string ref;
-								if(ss.peek() == '<') {
-									ss.get();
-									getline(ss, ref, '>');
-								} else {
-									ss >> ref;
-								}
-								auto dot = ref.find('.');
-								if(dot != string::npos) {
-									const string actorn = ref.substr(0, dot);
-									const string prop = ref.substr(dot + 1);
-									optional<string> actor;
-									if(!actorn.empty()) actor = actorn;
-									result.push_back(
-											unique_ptr<Renderer>(
-												new PropRef(actor, prop)
-											)
-									);
-								} else {
-									result.push_back(
-											unique_ptr<Renderer>(
-												new PlayerRef(ref)
-											)
-									);
-								}
-								break;
-							}
-
-							case '[': {
-								if(!literal.empty()) {
-									result.push_back(
-											unique_ptr<Renderer>(
-												new Literal(literal)
-											)
-									);
-									literal.clear();
-								}
-								optional<string> actor = parse_maybe_paren_name(ss);
-								string contents;
-								getline(ss, contents, ']');
-								istringstream reader(contents);
-								map<string, string> tenses;
-								string elem;
-								while(getline(reader, elem, '/')) {
-									trim(elem);
-									if(elem.empty()) continue;
-									auto pos = elem.find('=');
-									if(pos == string::npos) continue;
-									string k = elem.substr(0, pos);
-									string v = elem.substr(pos + 1);
-									tenses.insert_or_assign(k, v);
-								}
-								result.push_back(
-										unique_ptr<Renderer>(
-											new TenseChoice(actor, tenses)
-										)
-								);
-								break;
-							}
-
-							case '<': {
-								if(!literal.empty()) {
-									result.push_back(
-											unique_ptr<Renderer>(
-												new Literal(literal)
-											)
-									);
-									literal.clear();
-								}
-								optional<string> actor = parse_maybe_paren_name(ss);
-								Pronouns::Part p;
-								string contents;
-								getline(ss, contents, '>');
-								bool upcase = false;
-								if(!contents.empty() && isupper(contents[0])) {
-									contents[0] = tolower(contents[0]);
-									upcase = true;
-								}
-								if(contents == "s") {
-									p = Pronouns::Part::subject;
-								} else if(contents == "o") {
-									p = Pronouns::Part::object;
-								} else if(contents == "p") {
-									p = Pronouns::Part::possessive;
-								} else if(contents == "r") {
-									p = Pronouns::Part::reflexive;
-								} else if(contents == "'s") {
-									result.push_back(
-											unique_ptr<Renderer>(
-												new PossessiveParticle(actor)
-											)
-									);
-									break;
-								} else {
-									cerr << "unknown pronoun spec " << contents << "--I only know s, o, p, and r (and their uppercase variants)" << endl;
-									break;
-								}
-								result.push_back(
-										unique_ptr<Renderer>(
-											new Pronoun(actor, p, upcase)
-										)
-								);
-								break;
-							}
-
-							default: {
-								literal.push_back(c);
-								break;
-							}
-						}
-					}
+				Span add_text(string_view s) {
+					Span span{uint32_t(arena.size()), uint32_t(s.size())};
+					arena.append(s);
+					return span;
+				}
 
-					if(!literal.empty()) {
-						result.push_back(
-								unique_ptr<Renderer>(
-									new Literal(literal)
-								)
-						);
-					}
+				uint32_t add_slot(const optional<string_view> &actor) {
+					if(!actor) return LAST_PLAYER;
+					auto it = find(slots.begin(), slots.end(), *actor);
+					if(it == slots.end()) it = slots.insert(it, string(*actor));
+					return it - slots.begin();
+				}
+
+				// Like getline: the text up to delim (or all of it), which is
+				// removed from msg along with the delim
+				static string_view take_until(string_view &msg, char delim) {
+					size_t end = msg.find(delim);
+					string_view taken = msg.substr(0, end);
+					msg.remove_prefix(end == string_view::npos ? msg.size() : end + 1);
+					return taken;
+				}
 
-					return result;
+				static optional<string_view> parse_maybe_paren_name(string_view &msg) {
+					if(msg.starts_with('(')) {
+						msg.remove_prefix(1);
+						return make_optional(take_until(msg, ')'));
+					}
+					return optional<string_view>();
 				}
+		};
+
+		// A spec as an event holds it. Specs read from text are kept by the
+		// World, and ones that are alike and have no templates are read
+		// once and shared by every event that gives them (see
+		// World::intern_spec), so events refer to them rather than own them.
+		class SpecRef {
+			public:
+				ActorSpec *spec;
+
+				SpecRef() : spec(&none) {}
 
+				ActorSpec &operator*() const { return *spec; }
+				ActorSpec *operator->() const { return spec; }
+
+				ostream &write(ostream &os, const World &w) const { return spec->write(os, w); }
+				void read(TextReader &in, World &w);
+				void write_bin(BinWriter &out, const World &w) const { spec->write_bin(out, w); }
+				void read_bin(BinReader &in, World &w);
+
+			private:
+				// What an event without a world section has; never changed
+				static inline ActorSpec none;
 		};
 
-		Namespace<ActorSpec> actors;
-		ActorSpec world_spec;
+		Namespace<SpecRef> actors;
+		SpecRef world_spec;
 		RelSpec rel;
-		vector<unique_ptr<Renderer>> render;
+		Message message;
 		int multiplicity = 1, unlikeliness = 1;
+		size_t index = NO_INDEX;  // in World::events
+		// Whether world_spec held when the world's WorldGate last looked
+		bool world_open = true;
+
+		size_t involved_actors() const { return actors.size(); }
+
+		// A need's place in a binding
+		optional<size_t> slot_of(string_view need) const { return actors.rank(need); }
 
-		size_t involved_actors() { return actors.size(); }
+		// Resolves names in rel and in messages, once the world is read;
+		// false (with an error for each) if rel names an unknown relation
+		// or need. Unknown needs in messages are only warned about.
+		bool link(World &w, const string &name);
 
 		template<typename RNG>
 		bool should_happen(RNG &rng) { return rng() % unlikeliness == 0; }
 
 		ostream &write(ostream &os, const World &w) const;
-		istream &read(istream &is, World &w);
+		void read(TextReader &in, World &w);
+		void write_bin(BinWriter &out, const World &w) const;
+		void read_bin(BinReader &in, World &w);
 };
 
-ostream& operator<<(ostream &os, Event::Binding &b) {
-	for(const unique_ptr<Event::Renderer> &r: b.event.render)
-		r->render(os, b);
-	return os;
-}
-
-void Event::ActorSpec::mutate_additions(Player *ply, Event::Binding &b) const {
-	for(const string &s: attr_adds) {
-		ply->attrs.insert(s);
-	}
-	for(const auto &[key, val]: prop_adds) {
-		if(val.empty()) {
-			ply->props.erase(key);
-		} else {
-			auto msg = Event::render::parse_message(val);
-			ostringstream out;
-			for(const auto &cmp: msg) cmp->render(out, b);
-			ply->props.insert_or_assign(key, out.str());
+Event::Message::Message(string_view msg) {
+	// Each special form makes at most a literal and an instruction, and
+	// names at most one slot
+	size_t specials = count_if(msg.begin(), msg.end(), [](char c) { return c == '$' || c == '[' || c == '<'; });
+	arena.reserve(msg.size());
+	code.reserve(2 * specials + 1);
+	slots.reserve(specials);
+	tenses.reserve(count(msg.begin(), msg.end(), '='));
+	while(!msg.empty()) {
+		size_t special = msg.find_first_of("$[<");
+		if(special != 0) {
+			Span text = add_text(msg.substr(0, special));
+			// a literal after a literal (past a bad pronoun) just extends it
+			if(!code.empty() && code.back().op == Op::literal && code.back().text.offset + code.back().text.length == text.offset)
+				code.back().text.length += text.length;
+			else
+				emit(Op::literal).text = text;
+			if(special == string_view::npos) break;
+			msg.remove_prefix(special);
 		}
-	}
-}
+		char c = msg.front();
+		msg.remove_prefix(1);
+		switch(c) {
+			case '$': {
+				string_view ref;
+				if(msg.starts_with('<')) {
+					msg.remove_prefix(1);
+					ref = take_until(msg, '>');
+				} else {
+					ref = TextReader::trim(msg);
+					ref = ref.substr(0, find_if(ref.begin(), ref.end(), [](char c) {
+							return isspace(static_cast<unsigned char>(c));
+					}) - ref.begin());
+					msg.remove_prefix(ref.data() + ref.size() - msg.data());
+				}
+				auto dot = ref.find('.');
+				if(dot != string_view::npos) {
+					string_view actor = ref.substr(0, dot);
+					uint32_t slot = add_slot(actor.empty() ? optional<string_view>() : make_optional(actor));
+					Span prop = add_text(ref.substr(dot + 1));
+					Instr &in = emit(Op::prop_ref);
+					in.slot = slot;
+					in.text = prop;
+				} else {
+					uint32_t slot = add_slot(ref);
+					emit(Op::player_ref).slot = slot;
+				}
+				break;
+			}
 
-void Event::ActorSpec::mutate_deletions(Player *ply, Event::Binding &b) const {
-	for(const string &s: attr_removes) {
-		ply->attrs.erase(s);
-	}
-	for(const auto &[key, val]: prop_removes) {
-		if(val.empty()) {
-			ply->props.erase(key);
-		} else {
-			auto msg = Event::render::parse_message(val);
-			ostringstream out;
-			for(const auto &cmp: msg) cmp->render(out, b);
-			if(ply->props.contains(key) && ply->props.at(key) == out.str())
-				ply->props.erase(key);
+			case '[': {
+				uint32_t slot = add_slot(parse_maybe_paren_name(msg));
+				string_view contents = take_until(msg, ']');
+				size_t first = tenses.size();
+				while(!contents.empty()) {
+					string_view elem = TextReader::trim(take_until(contents, '/'));
+					auto pos = elem.find('=');
+					if(pos == string_view::npos) continue;
+					Span t = add_text(elem.substr(0, pos));
+					tenses.push_back({t, add_text(elem.substr(pos + 1))});
+				}
+				// By tense, the last choice given for a tense winning
+				auto choices = tenses.begin() + first;
+				auto by_tense = [this](const auto &a, const auto &b) { return view(a.first) < view(b.first); };
+				stable_sort(choices, tenses.end(), by_tense);
+				auto kept = choices;
+				for(auto it = choices; it != tenses.end(); it++) {
+					if(next(it) != tenses.end() && !by_tense(*it, *next(it))) continue;
+					*kept++ = *it;
+				}
+				tenses.erase(kept, tenses.end());
+				Span range{uint32_t(first), uint32_t(tenses.size() - first)};
+				Instr &in = emit(Op::tense_choice);
+				in.slot = slot;
+				in.text = range;
+				break;
+			}
+
+			case '<': {
+				uint32_t slot = add_slot(parse_maybe_paren_name(msg));
+				Pronouns::Part p;
+				string contents(take_until(msg, '>'));
+				bool upcase = false;
+				if(!contents.empty() && isupper(contents[0])) {
+					contents[0] = tolower(contents[0]);
+					upcase = true;
+				}
+				if(contents == "s") {
+					p = Pronouns::Part::subject;
+				} else if(contents == "o") {
+					p = Pronouns::Part::object;
+				} else if(contents == "p") {
+					p = Pronouns::Part::possessive;
+				} else if(contents == "r") {
+					p = Pronouns::Part::reflexive;
+				} else if(contents == "'s") {
+					emit(Op::possessive_particle).slot = slot;
+					break;
+				} else {
+					cerr << "unknown pronoun spec " << contents << "--I only know s, o, p, and r (and their uppercase variants)" << endl;
+					break;
+				}
+				Instr &in = emit(Op::pronoun);
+				in.slot = slot;
+				in.part = p;
+				in.upcase = upcase;
+				break;
+			}
 		}
 	}
 }
 
-class World {
-	public:
-		Namespace<Pronouns> pronouns;
-		Namespace<Player> players;
-		Namespace<Event> events;
-		Namespace<Relation> relations;
-		Player world_player{"<world>", nullptr};
-
-	friend ostream &operator<<(ostream &os, const World &w) {
-		os << "pronouns ";
-		w.pronouns.write(os, w);
-		os << endl;
-		os << "players ";
-		w.players.write(os, w);
-		os << endl;
-		os << "relations ";
-		w.relations.write(os, w);
-		os << endl;
-		os << "world [";
-		write_joined(os, w.world_player.attrs.begin(), w.world_player.attrs.end());
-		os << "]" << endl;
-		os << "events ";
-		w.events.write(os, w);
-		os << endl;
-		return os;
-	}
+template<typename String>
+void Event::Message::render(String &out, Binding &b) const {
+	auto actor = [&](const Instr &in) -> Player * {
+		if(in.slot == LAST_PLAYER) return b.last_player;
+		return b[binding_slots[in.slot]];
+	};
+
+	for(const Instr &in: code) {
+		switch(in.op) {
+			case Op::literal:
+				out.append(view(in.text));
+				break;
 
-	friend istream &operator>>(istream &is, World &w) {
-		w.pronouns.clear();
-		w.players.clear();
-		w.events.clear();
-		w.world_player.attrs.clear();
-
-		string section;
-		while(is >> section) {
-			if(section == "pronouns") {
-				w.pronouns.read(is, w);
-				is >> ws;
-			} else if(section == "players") {
-				w.players.read(is, w);
-				is >> ws;
-			} else if(section == "relations") {
-				w.relations.read(is, w);
-				is >> ws;
-			} else if(section == "events") {
-				w.events.read(is, w);
-				is >> ws;
-			} else if(section == "world") {
-				is >> ws;
-				vector<string> attrs = list_of_strings(is);
-				for(const string &s: attrs)
-					w.world_player.attrs.insert(s);
-			} else if(section == "---") {
-				break;  // common case that we read this from the previous state
-			} else {
-				cerr << "non-section: " << section << endl;
+			case Op::player_ref: {
+				if(Player *a = actor(in)) {
+					out.append(a->name);
+					b.last_player = a;
+				}
 				break;
 			}
-		}
 
-		return is;
-	}
-};
+			case Op::prop_ref: {
+				Player *ply = actor(in);
+				if(!ply) {
+					cerr << "propref has no actor--either it was used before any playerref or no player was bound to the named ref" << endl;
+					break;
+				}
+				b.last_player = ply;
+				auto it = ply->props.find(view(in.text));
+				if(it != ply->props.end()) out.append(it->second);
+				break;
+			}
 
-bool Event::RelSpec::satisfied(Event::Binding &b, const World &w) const {
-	for(const auto &[left, rel, right]: matches) {
-		const Relation *rp = w.relations.get(rel);
-		if(!rp) {
-			cerr << "relspec: relation " << rel << " does not exist" << endl;
-			continue;
+			case Op::tense_choice: {
+				Player *ply = actor(in);
+				if(!ply) {
+					cerr << "tensechoice has no actor--either it was used before any playerref or no player was bound to the named ref" << endl;
+					break;
+				}
+				if(!ply->pro) {
+					cerr << "player " << ply->name << " has no pronouns, can't pick a tense " << endl;
+					break;
+				}
+				for(uint32_t t = in.text.offset; t < in.text.offset + in.text.length; t++) {
+					if(view(tenses[t].first) == ply->pro->tense) {
+						out.append(view(tenses[t].second));
+						break;
+					}
+				}
+				break;
+			}
+
+			case Op::pronoun: {
+				Player *ply = actor(in);
+				if(!ply) {
+					cerr << "pronoun has no actor--either it was used before any playerref or no player was bound to the named ref" << endl;
+					break;
+				}
+				if(!ply->pro) {
+					cerr << "player " << ply->name << " has no pronouns, can't use one" << endl;
+					break;
+				}
+				const string &pro = ply->pro->get_part(in.part);
+				size_t at = out.size();
+				out.append(pro);
+				if(!pro.empty() && in.upcase) out[at] = toupper(out[at]);
+				b.last_player = ply;
+				break;
+			}
+
+			case Op::possessive_particle: {
+				Player *ply = actor(in);
+				if(!ply) {
+					cerr << "possessiveparticle has no actor--either it was used before any playerref or no player was bound to the named red" << endl;
+					break;
+				}
+				if(!ply->name.empty() && tolower(ply->name.back()) == 's') {
+					out.push_back('\'');
+				} else {
+					out.append("'s");
+				}
+				break;
+			}
 		}
-		Player *l = b.players[left], *r = b.players[right];
-		if(!l) {
-			cerr << "relspec: needsref " << left << " does not exist" << endl;
+	}
+}
+
+vector<string> Event::Message::link(const Event &e) {
+	vector<string> unknown;
+	// Each slot's index once the unknown ones are dropped, or NO_SLOT
+	constexpr uint32_t NO_SLOT = LAST_PLAYER - 1;
+	vector<uint32_t> renumber(slots.size());
+	binding_slots.clear();
+	for(size_t i = 0; i < slots.size(); i++) {
+		optional<size_t> slot = e.slot_of(slots[i]);
+		if(!slot) {
+			unknown.push_back(slots[i]);
+			renumber[i] = NO_SLOT;
 			continue;
 		}
-		if(!r) {
-			cerr << "relspec: needsref " << right << " does not exist" << endl;
+		renumber[i] = binding_slots.size();
+		binding_slots.push_back(*slot);
+	}
+	if(unknown.empty()) return unknown;
+
+	for(Instr &in: code) {
+		if(in.slot == LAST_PLAYER) continue;
+		uint32_t slot = renumber[in.slot];
+		if(slot != NO_SLOT) {
+			in.slot = slot;
 			continue;
 		}
-		if(!rp->contains(l, r)) return false;
+		ostringstream text;
+		if(in.op == Op::player_ref)
+			text << "$" << slots[in.slot];
+		else if(in.op == Op::prop_ref)
+			text << "$" << slots[in.slot] << "." << view(in.text);
+		else
+			write(text, in);
+		in = Instr{.op = Op::literal, .text = add_text(text.str())};
 	}
-	for(const auto &[left, rel, right]: neg_matches) {
-		const Relation *rp = w.relations.get(rel);
-		if(!rp) {
-			cerr << "relspec: relation " << rel << " does not exist" << endl;
-			continue;
+	size_t kept = 0;
+	for(size_t i = 0; i < slots.size(); i++)
+		if(renumber[i] != NO_SLOT) swap(slots[kept++], slots[i]);
+	slots.resize(kept);
+	return unknown;
+}
+
+ostream &Event::Message::write(ostream &os) const {
+	for(const Instr &in: code) write(os, in);
+	return os;
+}
+
+void Event::Message::write(ostream &os, const Instr &in) const {
+	auto write_actor = [&](const Instr &in) {
+		if(in.slot != LAST_PLAYER) os << "(" << slots[in.slot] << ")";
+	};
+	switch(in.op) {
+		case Op::literal:
+			os << view(in.text);
+			break;
+		case Op::player_ref:
+			os << "$<" << slots[in.slot] << ">";
+			break;
+		case Op::prop_ref:
+			os << "$<";
+			if(in.slot != LAST_PLAYER) os << slots[in.slot];
+			os << "." << view(in.text) << ">";
+			break;
+		case Op::tense_choice: {
+			os << "[";
+			write_actor(in);
+			auto first = tenses.begin() + in.text.offset;
+			write_joined(os, first, first + in.text.length, [this](const auto &choice) {
+					return string(view(choice.first)) + "=" + string(view(choice.second));
+			}, "/");
+			os << "]";
+			break;
 		}
-		Player *l = b.players[left], *r = b.players[right];
-		if(!l) {
-			cerr << "relspec: needsref " << left << " does not exist" << endl;
-			continue;
+		case Op::pronoun: {
+			os << "<";
+			write_actor(in);
+			string p;
+			switch(in.part) {
+				case Pronouns::Part::subject: p = "s"; break;
+				case Pronouns::Part::object: p = "o"; break;
+				case Pronouns::Part::possessive: p = "p"; break;
+				case Pronouns::Part::reflexive: p = "r"; break;
+			}
+			if(in.upcase) {
+				p[0] = toupper(p[0]);
+			}
+			os << p << ">";
+			break;
 		}
-		if(!r) {
-			cerr << "relspec: needsref " << right << " does not exist" << endl;
-			continue;
+		case Op::possessive_particle:
+			os << "<";
+			write_actor(in);
+			os << "'s>";
+			break;
+	}
+}
+
+void Event::Message::write_bin(BinWriter &out) const {
+	out.str(arena);
+	out.strs(slots.begin(), slots.end());
+	out.u32(code.size());
+	for(const Instr &in: code) {
+		out.u8(uint8_t(in.op));
+		out.u8(uint8_t(in.part));
+		out.u8(in.upcase);
+		out.u32(in.slot);
+		out.u32(in.text.offset);
+		out.u32(in.text.length);
+	}
+	out.u32(tenses.size());
+	for(const auto &[tense, repl]: tenses) {
+		for(Span s: {tense, repl}) {
+			out.u32(s.offset);
+			out.u32(s.length);
 		}
-		if(rp->contains(l, r)) return false;
 	}
-	// a bit of a special case of separating the matcher/mutator duty: don't allow
-	// an add to execute that would violate a reflex
-	for(const auto &[left, rel, right]: adds) {
-		const Relation *rp = w.relations.get(rel);
-		if(!rp) {
-			cerr << "relspec: relation " << rel << " does not exist" << endl;
-			continue;
+}
+
+void Event::Message::read_bin(BinReader &in) {
+	arena = in.str();
+	slots.clear();
+	in.strs(slots);
+	code.resize(in.u32());
+	for(Instr &i: code) {
+		i.op = Op(in.u8());
+		i.part = Pronouns::Part(in.u8());
+		i.upcase = in.u8();
+		i.slot = in.u32();
+		i.text.offset = in.u32();
+		i.text.length = in.u32();
+	}
+	tenses.resize(in.u32());
+	for(auto &[tense, repl]: tenses) {
+		for(Span *s: {&tense, &repl}) {
+			s->offset = in.u32();
+			s->length = in.u32();
 		}
-		Player *l = b.players[left], *r = b.players[right];
-		if(!l) {
-			cerr << "relspec: needsref " << left << " does not exist" << endl;
+	}
+
+	// Everything must point somewhere real, so rendering needn't check
+	auto in_arena = [&](Span s) { return uint64_t(s.offset) + s.length <= arena.size(); };
+	for(const auto &[tense, repl]: tenses)
+		if(!in_arena(tense) || !in_arena(repl)) in.ok = false;
+	for(const Instr &i: code) {
+		if(i.op > Op::possessive_particle || i.part > Pronouns::Part::reflexive) in.ok = false;
+		if(i.slot != LAST_PLAYER && i.slot >= slots.size()) in.ok = false;
+		if(i.op == Op::player_ref && i.slot == LAST_PLAYER) in.ok = false;
+		if(i.op == Op::tense_choice ? uint64_t(i.text.offset) + i.text.length > tenses.size() : !in_arena(i.text)) in.ok = false;
+	}
+}
+
+Event::Template::Template(string_view src) : source(src) {
+	if(source.empty()) return;
+	program = make_unique<Message>(source);
+	if(program->literal()) {
+		for(const Message::Instr &in: program->code)
+			text += program->view(in.text);
+		program.reset();
+	}
+}
+
+string Event::Template::expand(Event::Binding &b) const {
+	if(plain()) return text;
+	string out;
+	program->render(out, b);
+	return out;
+}
+
+ostream& operator<<(ostream &os, Event::Binding &b) {
+	string out;
+	b.event.message.render(out, b);
+	return os << out;
+}
+
+// Removes a property, recording it if it was there
+static void erase_prop(Player *ply, decltype(Player::props)::iterator it, ChangeLog *changes) {
+	if(changes) changes->prop(ply, it->first, it->second, optional<string>());
+	ply->props.erase(it);
+}
+
+void Event::ActorSpec::mutate_additions(Player *ply, Event::Binding &b, ChangeLog *changes, const vector<string> *values) const {
+	for(const string &s: attr_adds) {
+		if(ply->attrs.insert(s).second && changes) changes->attr(ply, s, true);
+	}
+	ply->attr_mask |= attr_add_mask;
+	size_t i = 0;
+	for(const auto &[key, val]: prop_adds) {
+		auto it = ply->props.find(key);
+		if(val.source.empty()) {
+			if(it != ply->props.end()) erase_prop(ply, it, changes);
+			i++;
 			continue;
 		}
-		if(!r) {
-			cerr << "relspec: needsref " << right << " does not exist" << endl;
-			continue;
+		string value = values ? (*values)[i] : val.expand(b);
+		i++;
+		if(it == ply->props.end()) {
+			if(changes) changes->prop(ply, key, optional<string>(), value);
+			ply->props.emplace(key, move(value));
+		} else if(it->second != value) {
+			if(changes) changes->prop(ply, key, it->second, value);
+			it->second = move(value);
 		}
-		if(!rp->allow_reflex && l == r) return false;
 	}
-	return true;
 }
 
-void Event::RelSpec::mutate(Event::Binding &b, World &w) const {
-	for(const auto &[left, rel, right]: adds) {
-		Relation *rp = w.relations.get(rel);
-		if(!rp) {
-			cerr << "relspec: relation " << rel << " does not exist" << endl;
-			continue;
+vector<string> Event::ActorSpec::expand_adds(Event::Binding &b) const {
+	vector<string> values;
+	values.reserve(prop_adds.size());
+	for(const auto &[_, val]: prop_adds)
+		values.push_back(val.source.empty() ? string() : val.expand(b));
+	return values;
+}
+
+void Event::ActorSpec::mutate_deletions(Player *ply, Event::Binding &b, ChangeLog *changes) const {
+	for(const string &s: attr_removes) {
+		if(ply->attrs.erase(s) && changes) changes->attr(ply, s, false);
+	}
+	ply->attr_mask &= ~attr_remove_mask;
+	for(const auto &[key, val]: prop_removes) {
+		auto it = ply->props.find(key);
+		if(it == ply->props.end()) continue;
+		if(val.source.empty() || (val.plain() ? it->second == val.text : it->second == val.expand(b)))
+			erase_prop(ply, it, changes);
+	}
+}
+
+// For each distinct needs spec among the events, the live players it
+// currently matches, as a bitmap by Roster place. Effects mark the players
+// they change, and only those are tested again before the next round, so
+// keeping this current costs about (changed players) x (distinct specs)
+// rather than a test of every player against every spec as events are bound.
+// This is also where players are moved in or out of the retired part of the
+// roster.
+class MatchCache {
+	public:
+		class Entry {
+			public:
+				vector<uint64_t> bits;
+				size_t count = 0;
+				// Whether retired players are counted too; needs only ever
+				// bind live ones
+				bool with_retired = false;
+
+				bool has(uint32_t place) const {
+					return place / 64 < bits.size() && (bits[place / 64] >> (place % 64) & 1);
+				}
+
+				void set(uint32_t place, bool on) {
+					uint64_t &word = bits[place / 64], bit = uint64_t(1) << (place % 64);
+					if(bool(word & bit) == on) return;
+					word ^= bit;
+					if(on) count++;
+					else count--;
+				}
+
+				void swap(uint32_t a, uint32_t b) {
+					if(has(a) == has(b)) return;
+					bits[a / 64] ^= uint64_t(1) << (a % 64);
+					bits[b / 64] ^= uint64_t(1) << (b % 64);
+				}
+		};
+
+		void build(World &w);
+
+		// p's attributes or properties may have changed
+		void touch(Player *p) {
+			if(p->index >= dirty_flags.size() || dirty_flags[p->index]) return;
+			dirty_flags[p->index] = true;
+			dirty.push_back(p);
 		}
-		Player *l = b.players[left], *r = b.players[right];
-		if(!l) {
-			cerr << "relspec: needsref " << left << " does not exist" << endl;
-			continue;
+
+		// Brings every entry, and the roster, up to date with the players
+		// touched since
+		void refresh();
+
+		// The free player in pool that matches spec and comes first in pool
+		// order, if any
+		Player *first(const Event::ActorSpec &spec, const PlayerPool &pool) const;
+		// Every free player in pool that matches spec, in pool order
+		void all(const Event::ActorSpec &spec, const PlayerPool &pool, pmr::vector<Player *> &into) const;
+
+		// Keeps an entry for a spec that isn't a need, such as a game's
+		// filter, counting retired players as well
+		void watch(Event::ActorSpec &spec);
+		size_t count(const Event::ActorSpec &spec) const { return entries[*spec.match_entry].second.count; }
+		// Every player matching a watched spec, in name order
+		vector<Player *> matching(const Event::ActorSpec &spec) const;
+
+	private:
+		vector<pair<const Event::ActorSpec *, Entry>> entries;
+		Roster *roster = nullptr;
+		const Event::ActorSpec *retire = nullptr;
+		vector<Player *> dirty;
+		vector<bool> dirty_flags;
+
+		void add_entry(const Event::ActorSpec &spec, bool with_retired);
+
+		template<typename F>
+		void for_each(const Entry &e, F f) const {
+			size_t words = e.with_retired ? e.bits.size() : (roster->live_places() + 63) / 64;
+			for(size_t w = 0; w < words; w++) {
+				for(uint64_t word = e.bits[w]; word; word &= word - 1)
+					f(roster->at(w * 64 + countr_zero(word)));
+			}
 		}
-		if(!r) {
-			cerr << "relspec: needsref " << right << " does not exist" << endl;
-			continue;
+};
+
+// Which events' world specs the world player meets. The world only changes
+// between rounds, so this is worked out once per round rather than at every
+// draw, and only for the events whose world specs mention an attribute or
+// property key of the world player that changed since the last refresh.
+class WorldGate {
+	public:
+		void build(Namespace<Event> &events, const Player &world) {
+			by_attr.clear();
+			by_prop.clear();
+			for(auto &[_, event]: events.by_name()) {
+				const Event::ActorSpec &spec = *event.world_spec;
+				for(const set<string> *attrs: {&spec.attr_matches, &spec.attr_neg_matches})
+					for(const string &attr: *attrs) by_attr[attr].push_back(&event);
+				for(const map<string, string> *props: {&spec.prop_matches, &spec.prop_neg_matches})
+					for(const auto &[key, _]: *props) by_prop[key].push_back(&event);
+				event.world_open = spec.applies_to(&world);
+			}
+			seen_attrs = world.attrs;
+			seen_props = world.props;
 		}
-		rp->insert(l, r);
-	}
-	for(const auto &[left, rel, right]: removes) {
-		Relation *rp = w.relations.get(rel);
-		if(!rp) {
-			cerr << "relspec: relation " << rel << " does not exist" << endl;
-			continue;
+
+		void refresh(const Player &world) {
+			if(world.attrs == seen_attrs && world.props == seen_props) return;
+			set<Event *> stale;
+			auto touch = [&stale](const map<string, vector<Event *>, less<>> &index, const string &key) {
+				auto it = index.find(key);
+				if(it != index.end()) stale.insert(it->second.begin(), it->second.end());
+			};
+			vector<string> attrs;
+			set_symmetric_difference(seen_attrs.begin(), seen_attrs.end(), world.attrs.begin(), world.attrs.end(), back_inserter(attrs));
+			for(const string &attr: attrs) touch(by_attr, attr);
+			for(const auto &[key, val]: seen_props) {
+				auto it = world.props.find(key);
+				if(it == world.props.end() || it->second != val) touch(by_prop, key);
+			}
+			for(const auto &[key, _]: world.props) {
+				if(!seen_props.contains(key)) touch(by_prop, key);
+			}
+			for(Event *event: stale) event->world_open = event->world_spec->applies_to(&world);
+			seen_attrs = world.attrs;
+			seen_props = world.props;
 		}
-		Player *l = b.players[left], *r = b.players[right];
-		if(!l) {
-			cerr << "relspec: needsref " << left << " does not exist" << endl;
-			continue;
+
+	private:
+		map<string, vector<Event *>, less<>> by_attr, by_prop;
+		// The world player as of the last refresh
+		set<string> seen_attrs;
+		map<string, string, less<>> seen_props;
+};
+
+class World {
+	public:
+		Namespace<Pronouns> pronouns;
+		Namespace<Player> players;
+		Namespace<Event> events;
+		Namespace<Relation> relations;
+		Player world_player{"<world>", nullptr};
+		Symbols attr_symbols;
+		WorldGate gate;
+		MatchCache matches;
+		// Players matching this are out of the game: they stay in the
+		// world, but rounds leave them out of the pool
+		optional<Event::ActorSpec> retire;
+		Roster roster;  // kept by matches
+		// What events' SpecRefs refer to; specs is a deque so that they stay
+		// put as more are read
+		deque<Event::ActorSpec> specs;
+		map<string, Event::ActorSpec *, less<>> spec_texts;  // the shared ones, by text
+
+		// Reads a spec, or finds the one read earlier from the same text
+		Event::ActorSpec *intern_spec(TextReader &in) {
+			size_t at = in.mark();
+			if(Event::ActorSpec::skip(in)) {
+				auto it = spec_texts.find(TextReader::trim(in.view(at)));
+				if(it != spec_texts.end()) return it->second;
+			}
+			in.seek(at);
+			Event::ActorSpec &spec = specs.emplace_back();
+			spec.read(in, *this);
+			// Templates are linked to one event's needs, so can't be shared
+			if(in.ok && !spec.has_templates()) spec_texts.emplace(TextReader::trim(in.view(at)), &spec);
+			return &spec;
 		}
-		if(!r) {
-			cerr << "relspec: needsref " << right << " does not exist" << endl;
-			continue;
+
+	void clear() {
+		pronouns.clear();
+		players.clear();
+		relations.clear();
+		events.clear();
+		world_player.clear_attrs();
+		world_player.props.clear();
+		retire.reset();
+		specs.clear();
+		spec_texts.clear();
+		attr_symbols.clear();
+	}
+
+	void write_binary(ostream &os) const;
+	bool read_binary(string_view data);
+
+	friend ostream &operator<<(ostream &os, const World &w) {
+		os << "pronouns ";
+		w.pronouns.write(os, w);
+		os << endl;
+		os << "players ";
+		w.players.write(os, w);
+		os << endl;
+		os << "relations ";
+		w.relations.write(os, w);
+		os << endl;
+		os << "world [";
+		write_joined(os, w.world_player.attrs.begin(), w.world_player.attrs.end());
+		os << "]" << endl;
+		if(w.retire) os << "retire " << *w.retire << endl;
+		os << "events ";
+		w.events.write(os, w);
+		os << endl;
+		return os;
+	}
+
+	void read(TextReader &in) {
+		clear();
+
+		while(in.ok) {
+			in.skip_ws();
+			size_t at = in.mark();
+			string_view section = in.word();
+			if(section.empty()) {
+				break;
+			} else if(section == "pronouns") {
+				pronouns.read(in, *this);
+			} else if(section == "players") {
+				players.read(in, *this);
+			} else if(section == "relations") {
+				relations.read(in, *this);
+			} else if(section == "events") {
+				events.read(in, *this);
+			} else if(section == "world") {
+				in.skip_ws();
+				for(string_view s: in.list()) {
+					string attr(s);
+					world_player.insert_attr(attr, attr_symbols.intern(attr));
+				}
+			} else if(section == "retire") {
+				in.skip_ws();
+				retire.emplace();
+				retire->read(in, *this);
+			} else if(section == "---") {
+				break;  // common case that we read this from the previous state
+			} else {
+				in.warn("non-section: " + string(section), at);
+				break;
+			}
 		}
-		rp->erase(l, r);
+		if(in.ok && !link()) in.ok = false;
+	}
+
+	bool link() {
+		bool ok = true;
+		for(auto &[name, event]: events.by_name())
+			ok &= event.link(*this, name);
+		gate.build(events, world_player);
+		matches.build(*this);
+		return ok;
 	}
+
+	friend istream &operator>>(istream &is, World &w) {
+		string text(istreambuf_iterator<char>(is), {});
+		TextReader in(text);
+		w.read(in);
+		if(!in.ok) is.setstate(ios_base::failbit);
+		return is;
+	}
+
+};
+
+void Event::SpecRef::read(TextReader &in, World &w) {
+	spec = w.intern_spec(in);
 }
 
-static optional<Event::Binding> _try_bind_fastpath(const Event &e, const World &w, vector<Player *> &players, bool use_attrs) {
-	map<string, Player *> bindings;
+void Event::SpecRef::read_bin(BinReader &in, World &w) {
+	spec = &w.specs.emplace_back();
+	spec->read_bin(in, w);
+}
 
-	for(const auto &[name, spec]: e.actors.forward) {
-		auto it = players.begin();
-		bool found = false;
-		while(it != players.end()) {
-			if(!use_attrs || spec.applies_to(*it)) {
-				bindings.insert_or_assign(name, *it);
-				players.erase(it);
-				found = true;
-				break;
+void Event::ActorSpec::compile(World &w) {
+	attr_must.reset();
+	attr_must_not.reset();
+	attr_add_mask.reset();
+	attr_remove_mask.reset();
+	attr_slow_matches.clear();
+	attr_slow_neg_matches.clear();
+
+	for(const string &s: attr_matches) {
+		size_t id = w.attr_symbols.intern(s);
+		if(id < ATTR_BITS) attr_must.set(id);
+		else attr_slow_matches.push_back(s);
+	}
+	for(const string &s: attr_neg_matches) {
+		size_t id = w.attr_symbols.intern(s);
+		if(id < ATTR_BITS) attr_must_not.set(id);
+		else attr_slow_neg_matches.push_back(s);
+	}
+	// Players only get mask bits for ids below ATTR_BITS, so the rest are
+	// safe to leave to the string sets in the mutators.
+	for(const string &s: attr_adds) {
+		size_t id = w.attr_symbols.intern(s);
+		if(id < ATTR_BITS) attr_add_mask.set(id);
+	}
+	for(const string &s: attr_removes) {
+		size_t id = w.attr_symbols.intern(s);
+		if(id < ATTR_BITS) attr_remove_mask.set(id);
+	}
+}
+
+bool Event::RelSpec::satisfied(const Event::Binding &b) const {
+	for(const Link &l: match_links)
+		if(!l.rel->contains(b[l.left], b[l.right])) return false;
+	for(const Link &l: neg_match_links)
+		if(l.rel->contains(b[l.left], b[l.right])) return false;
+	// a bit of a special case of separating the matcher/mutator duty: don't allow
+	// an add to execute that would violate a reflex
+	for(const Link &l: add_links)
+		if(!l.rel->allow_reflex && b[l.left] == b[l.right]) return false;
+	return true;
+}
+
+void Event::RelSpec::mutate(const Event::Binding &b, ChangeLog *changes) const {
+	for(const Link &l: add_links)
+		l.rel->insert(b[l.left], b[l.right], changes);
+	for(const Link &l: remove_links)
+		l.rel->erase(b[l.left], b[l.right], changes);
+}
+
+bool Event::link(World &w, const string &name) {
+	bool ok = true;
+	auto fail = [&](const string &why) {
+		cerr << "event " << name << ": " << why << endl;
+		ok = false;
+	};
+
+	auto link_triples = [&](const set<RelSpec::Triple> &triples, vector<RelSpec::Link> &links) {
+		links.clear();
+		for(const auto &[left, relname, right]: triples) {
+			Relation *r = w.relations.get(relname);
+			optional<size_t> l = slot_of(left), rt = slot_of(right);
+			if(!r) fail("rel names no relation " + relname);
+			if(!l) fail("rel names no need " + left);
+			if(!rt) fail("rel names no need " + right);
+			if(r && l && rt) links.push_back({*l, r, *rt});
+		}
+	};
+	link_triples(rel.matches, rel.match_links);
+	link_triples(rel.neg_matches, rel.neg_match_links);
+	link_triples(rel.adds, rel.add_links);
+	link_triples(rel.removes, rel.remove_links);
+
+	// Not fatal: the ref is printed as written
+	auto warn = [&](const string &where, const vector<string> &unknown) {
+		for(const string &need: unknown)
+			cerr << "event " << name << ": " << where << " names no need " << need << " (it's printed as written)" << endl;
+	};
+	warn("message", message.link(*this));
+	auto link_templates = [&](ActorSpec &spec) {
+		for(map<string, Template> *props: {&spec.prop_adds, &spec.prop_removes}) {
+			for(auto &[key, value]: *props) {
+				if(value.program) warn("property " + key, value.program->link(*this));
 			}
-			it++;
 		}
-		if(!found) return optional<Event::Binding>();
+	};
+	for(auto &[_, need]: actors.by_name()) link_templates(*need);
+	link_templates(*world_spec);
+	return ok;
+}
+
+static optional<Event::Binding> _try_bind_fastpath(const Event &e, const World &w, PlayerPool &players, bool use_attrs, EventStats *stats, pmr::memory_resource *mem) {
+	Event::Binding bindings(e, mem);
+	size_t slot = 0;
+
+	for(const auto &[name, need]: e.actors.by_name()) {
+		Player *p = nullptr;
+		if(use_attrs) p = w.matches.first(*need, players);
+		else if(auto it = players.begin(); it != players.end()) p = *it;
+		if(!p) {
+			if(stats) stats->no_candidate[name]++;
+			players.rollback();
+			return optional<Event::Binding>();
+		}
+		bindings[slot++] = p;
+		players.take(p);
 	}
 
-	return make_optional(Event::Binding(e, bindings));
+	return make_optional(move(bindings));
 }
 
-optional<Event::Binding> Event::Binding::try_bind(const Event &e, const World &w, vector<Player *> &players, bool use_attrs) {
-	if(use_attrs && !e.world_spec.applies_to(&w.world_player)) return optional<Binding>();
-	if(!use_attrs || e.rel.empty()) return _try_bind_fastpath(e, w, players, use_attrs);
+// Binds an event with a non-empty `rel` section. This finds the same binding
+// as trying every combination of candidates in odometer order (the first
+// slot varying fastest, each slot's candidates in pool order), but does so as
+// a backtracking search: slots are bound from the last to the first, each
+// relation constraint is checked as soon as both of its ends are bound, a
+// player already bound is skipped immediately, and a slot whose candidates
+// are constrained to be neighbours of a bound player is drawn from that
+// player's adjacency list rather than filtered from all candidates. After
+// each slot is bound, slots that must be related to it are checked for at
+// least one remaining candidate, so dead ends are abandoned early.
+class RelationalBinder {
+	public:
+		// Scratch space comes from arena
+		RelationalBinder(const Event &e, const World &w, PlayerPool &pool, EventStats *stats, pmr::memory_resource *arena) : event(e), world(w), pool(pool), stats(stats), arena(arena), slots(arena) {}
+
+		// The binding found keeps its players in mem, which outlives the
+		// scratch space
+		optional<Event::Binding> bind(pmr::memory_resource *mem) {
+			slots.reserve(event.actors.size());
+			for(const auto &[name, need]: event.actors.by_name()) {
+				Slot &slot = slots.emplace_back(need.spec, arena);
+				world.matches.all(*need, pool, slot.candidates);
+				if(slot.candidates.empty()) {  // no way to proceed if any set is empty
+					if(stats) stats->no_candidate[name]++;
+					return optional<Event::Binding>();
+				}
+			}
 
-	// theorem: use_attrs is asserted here
-	map<string, vector<Player *>> candidates;
-	for(const auto &[name, spec]: e.actors.forward) {
-		vector<Player *> avail;
-		for(Player *p: players) {
-			if(spec.applies_to(p))
-				avail.push_back(p);
-		}
-		if(avail.empty()) return optional<Event::Binding>();  // no way to proceed if any set is empty
-		candidates.insert_or_assign(name, avail);
-	}
-
-	// we need an order on keys, so we assemble it here
-	vector<string> keys;
-	vector<vector<Player *>> sets;
-	vector<int> indices;
-	for(const auto &[name, set]: candidates) {
-		keys.push_back(name);
-		indices.push_back(0);
-		sets.push_back(set);
-	}
-
-	while(true) {
-		map<string, Player *> bindings;
-		set<Player *> seen;
-		bool skip = false;
-		for(int i = 0; i < keys.size(); i++) {
-			Player *p = sets[i][indices[i]];
-			if(seen.contains(p)) {
-				skip = true;
-				break;
+			add_constraints(event.rel.match_links, Constraint::Kind::related);
+			add_constraints(event.rel.neg_match_links, Constraint::Kind::unrelated);
+			add_constraints(event.rel.add_links, Constraint::Kind::not_reflexive);
+
+			if(!search(slots.size())) {
+				if(stats) stats->unsatisfied++;
+				return optional<Event::Binding>();
+			}
+
+			Event::Binding bindings(event, mem);
+			for(size_t i = 0; i < slots.size(); i++) {
+				bindings[i] = slots[i].bound;
+				pool.take(slots[i].bound);
+			}
+			return make_optional(move(bindings));
+		}
+
+	private:
+		class Constraint {
+			public:
+				enum class Kind { related, unrelated, not_reflexive };
+				Kind kind;
+				const Relation *rel;
+				size_t left, right;  // slot numbers
+		};
+
+		class Slot {
+			public:
+				const Event::ActorSpec *spec;
+				pmr::vector<Player *> candidates;
+				Player *bound = nullptr;
+				pmr::vector<Constraint> checks;  // to test once this slot is bound
+				pmr::vector<Constraint> links;  // `related` constraints to other slots
+
+				Slot(const Event::ActorSpec *spec, pmr::memory_resource *arena) : spec(spec), candidates(arena), checks(arena), links(arena) {}
+		};
+
+		const Event &event;
+		const World &world;
+		PlayerPool &pool;
+		EventStats *stats;
+		pmr::memory_resource *arena;
+		pmr::vector<Slot> slots;
+
+		// Slots are numbered as in a Binding, so links apply directly
+		void add_constraints(const vector<Event::RelSpec::Link> &links, Constraint::Kind kind) {
+			for(const auto &[l, rp, r]: links) {
+				// Distinct slots always hold distinct players, so only a
+				// slot related to itself can violate reflexivity.
+				if(kind == Constraint::Kind::not_reflexive && (l != r || rp->allow_reflex)) continue;
+				Constraint c{kind, rp, l, r};
+				// Slots are bound from the last to the first, so the lower
+				// numbered end is the one bound later.
+				slots[min(l, r)].checks.push_back(c);
+				if(kind == Constraint::Kind::related && l != r) {
+					slots[l].links.push_back(c);
+					slots[r].links.push_back(c);
+				}
 			}
-			seen.insert(p);
-			bindings.insert_or_assign(keys[i], p);
 		}
-		if(!skip) {
-			Binding b(e, bindings);
-			if(e.rel.satisfied(b, w)) {
-				erase_if(players, [&seen](Player *&p) { return seen.contains(p); });
-				return make_optional(b);
+
+		bool is_bound(const Player *p) const {
+			for(const Slot &slot: slots) {
+				if(slot.bound == p) return true;
 			}
+			return false;
 		}
 
-		bool exhausted = true;
-		for(int i = 0; i < keys.size(); i++) {
-			indices[i]++;
-			if(indices[i] >= sets[i].size()) {
-				indices[i] = 0;
-			} else {
-				exhausted = false;
-				break;
+		bool is_candidate(const Slot &slot, const Player *p) const {
+			return pool.is_free(p) && slot.spec->applies_to(p) && !is_bound(p);
+		}
+
+		bool holds(const Constraint &c) const {
+			const Player *l = slots[c.left].bound, *r = slots[c.right].bound;
+			switch(c.kind) {
+				case Constraint::Kind::related: return c.rel->contains(l, r);
+				case Constraint::Kind::unrelated: return !c.rel->contains(l, r);
+				case Constraint::Kind::not_reflexive: return false;
 			}
+			return false;
 		}
-		if(exhausted) break;
-	}
-	return optional<Event::Binding>();
+
+		// The players that can be at `other` given that `bound` holds the
+		// far end of c, if the relation can list them directly.
+		const vector<Player *> *neighbours_for(const Constraint &c, size_t other) const {
+			size_t near = c.left == other ? c.right : c.left;
+			const Player *p = slots[near].bound;
+			if(!p) return nullptr;
+			if(c.left == near || !c.rel->directional) return &c.rel->neighbours(p);
+			return nullptr;
+		}
+
+		// Every slot constrained to be related to a newly bound one must
+		// still have some candidate that it could be related to.
+		bool lookahead(size_t just_bound) const {
+			for(const Constraint &c: slots[just_bound].links) {
+				size_t other = c.left == just_bound ? c.right : c.left;
+				const Slot &slot = slots[other];
+				if(slot.bound) continue;
+				const vector<Player *> *near = neighbours_for(c, other);
+				if(!near) continue;
+				if(none_of(near->begin(), near->end(), [&](const Player *p) { return is_candidate(slot, p); }))
+					return false;
+			}
+			return true;
+		}
+
+		bool search(size_t unbound) {
+			if(unbound == 0) return true;
+			size_t me = unbound - 1;
+			Slot &slot = slots[me];
+
+			const pmr::vector<Player *> *source = &slot.candidates;
+			pmr::vector<Player *> narrowed(arena);
+			const vector<Player *> *smallest = nullptr;
+			for(const Constraint &c: slot.checks) {
+				if(c.kind != Constraint::Kind::related || c.left == c.right) continue;
+				const vector<Player *> *near = neighbours_for(c, me);
+				if(near && (!smallest || near->size() < smallest->size())) smallest = near;
+			}
+			if(smallest && smallest->size() < slot.candidates.size()) {
+				for(Player *p: *smallest) {
+					if(is_candidate(slot, p)) narrowed.push_back(p);
+				}
+				sort(narrowed.begin(), narrowed.end(), [this](const Player *a, const Player *b) {
+						return pool.rank_of(a) < pool.rank_of(b);
+				});
+				source = &narrowed;
+			}
+
+			for(Player *p: *source) {
+				if(is_bound(p)) continue;
+				if(stats) stats->combinations++;
+				slot.bound = p;
+				if(all_of(slot.checks.begin(), slot.checks.end(), [this](const Constraint &c) { return holds(c); })
+						&& lookahead(me) && search(me))
+					return true;
+			}
+			slot.bound = nullptr;
+			return false;
+		}
+};
+
+optional<Event::Binding> Event::Binding::try_bind(const Event &e, const World &w, PlayerPool &players, bool use_attrs, EventStats *stats, pmr::memory_resource *arena) {
+	if(!use_attrs || e.rel.empty()) return _try_bind_fastpath(e, w, players, use_attrs, stats, arena);
+
+	// theorem: use_attrs is asserted here
+	// one attempt's scratch usually fits on the stack; it all goes at once
+	array<byte, 4096> buffer;
+	pmr::monotonic_buffer_resource scratch(buffer.data(), buffer.size(), arena);
+	return RelationalBinder(e, w, players, stats, &scratch).bind(arena);
 }
 
-void Event::Binding::cause_effects(World &w) {
+void Event::Binding::cause_effects(World &w, ChangeLog *changes) {
 	// We make this two-pass here because props can depend on (the rendering of)
 	// other props, and thus it's a bad idea to remove them first when they may
 	// be referenced elsewhere.
 
-	for(auto &[key, ply]: players) {
-		auto spec = event.actors.get(key);
-		if(spec) {
-			spec->mutate_additions(ply, *this);
-		}
+	size_t slot = 0;
+	for(const auto &[_, need]: event.actors.by_name())
+		need->mutate_additions((*this)[slot++], *this, changes);
+	event.world_spec->mutate_additions(&w.world_player, *this, changes);
+
+	slot = 0;
+	for(const auto &[_, need]: event.actors.by_name()) {
+		Player *ply = (*this)[slot++];
+		need->mutate_deletions(ply, *this, changes);
+		if(need->changes_anything()) w.matches.touch(ply);
 	}
-	event.world_spec.mutate_additions(&w.world_player, *this);
+	event.world_spec->mutate_deletions(&w.world_player, *this, changes);
 
-	for(auto &[key, ply]: players) {
-		auto spec = event.actors.get(key);
-		if(spec) {
-			spec->mutate_deletions(ply, *this);
-		}
+	event.rel.mutate(*this, changes);
+}
+
+void Event::Binding::cause_player_effects(ChangeLog *changes, vector<string> &world_adds) {
+	size_t slot = 0;
+	for(const auto &[_, need]: event.actors.by_name())
+		need->mutate_additions((*this)[slot++], *this, changes);
+	world_adds = event.world_spec->expand_adds(*this);
+
+	slot = 0;
+	for(const auto &[_, need]: event.actors.by_name())
+		need->mutate_deletions((*this)[slot++], *this, changes);
+}
+
+// The players are as cause_effects would leave them by now, so the world
+// spec's prop_removes render as they would have there
+void Event::Binding::cause_world_effects(World &w, const vector<string> &world_adds, ChangeLog *changes) {
+	event.world_spec->mutate_additions(&w.world_player, *this, changes, &world_adds);
+	size_t slot = 0;
+	for(const auto &[_, need]: event.actors.by_name()) {
+		Player *ply = (*this)[slot++];
+		if(need->changes_anything()) w.matches.touch(ply);
 	}
-	event.world_spec.mutate_deletions(&w.world_player, *this);
+	event.world_spec->mutate_deletions(&w.world_player, *this, changes);
 
-	event.rel.mutate(*this, w);
+	event.rel.mutate(*this, changes);
 }
 
+// The events left to be drawn in a round. Each distinct event is stored once
+// with its remaining multiplicity, and a draw picks one with probability
+// proportional to that count (using a Fenwick tree of the counts) and then
+// decrements it. That is the same distribution as shuffling `multiplicity`
+// copies of every event and dealing from the top, without the copies.
+class EventDeck {
+	public:
+		void add(Event *ev, uint64_t count) {
+			if(count == 0) return;
+			events.push_back(ev);
+			counts.push_back(count);
+			remaining += count;
+			built = false;
+		}
+
+		bool empty() const { return remaining == 0; }
+		uint64_t size() const { return remaining; }
+
+		template<typename RNG>
+		Event *draw(RNG &rng) {
+			if(!built) build();
+			uint64_t target = uniform_int_distribution<uint64_t>(0, remaining - 1)(rng);
+			// Find the first event whose running total of counts exceeds target
+			size_t pos = 0;
+			for(size_t step = top_bit; step; step >>= 1) {
+				if(pos + step <= tree.size() && tree[pos + step - 1] <= target) {
+					pos += step;
+					target -= tree[pos - 1];
+				}
+			}
+			counts[pos]--;
+			remaining--;
+			for(size_t i = pos + 1; i <= tree.size(); i += i & -i) tree[i - 1]--;
+			return events[pos];
+		}
+
+	private:
+		vector<Event *> events;
+		vector<uint64_t> counts;
+		vector<uint64_t> tree;  // Fenwick tree over counts, 1-based in the math
+		size_t top_bit = 0;
+		uint64_t remaining = 0;
+		bool built = false;
+
+		void build() {
+			tree = counts;
+			for(size_t i = 1; i <= tree.size(); i++) {
+				size_t parent = i + (i & -i);
+				if(parent <= tree.size()) tree[parent - 1] += tree[i - 1];
+			}
+			top_bit = 1;
+			while(top_bit * 2 <= tree.size()) top_bit *= 2;
+			built = true;
+		}
+};
+
 class Round {
 	public:
+		// What binding and rendering allocate along the way comes from
+		// arena, and is all given back at once when the round ends;
+		// shared_arena is the same for work spread over several threads
+		pmr::unsynchronized_pool_resource arena{pmr::pool_options{0, 1 << 20}};
+		pmr::synchronized_pool_resource shared_arena{pmr::pool_options{0, 1 << 20}};
+
 		World &world;
 		mt19937 rng;
-		vector<Player *> player_pool;
-		vector<Event *> player_events;
-		vector<Event *> unassoc_events;
-		vector<Event::Binding> bindings;
+		PlayerPool player_pool;
+		EventDeck player_events;
+		EventDeck unassoc_events;
+		vector<const Event *> closed_events;  // by their world specs
+		pmr::vector<Event::Binding> bindings{&arena};
+
+		pmr::vector<pmr::string> messages{&arena};
+		// If set, each message is written (and flushed) here as soon as its
+		// event is bound, instead of being kept in messages.
+		ostream *message_sink = nullptr;
+		// Batch runs don't read messages, so needn't render them
+		bool narrate = true;
+		// With more than one, messages are rendered and effects applied on
+		// this many threads once binding is done; messages are only then
+		// written to message_sink
+		size_t threads = 1;
+		// If set, counters for this round are added here
+		RoundStats *stats = nullptr;
+		// If set, every change the effects make is recorded here
+		ChangeLog *changes = nullptr;
+
+		Round(World &w, mt19937 seeded) : world(w), rng(seeded) {
+			world.matches.refresh();
+			vector<Player *> players;
+			world.roster.live(players);
+
+			// Events the world rules out are left out of the decks
+			world.gate.refresh(world.world_player);
+			for(auto &[_, event]: world.events.by_name()) {
+				Event *ev = &event;
+				if(!ev->world_open) {
+					closed_events.push_back(ev);
+					continue;
+				}
+				uint64_t copies = max(ev->multiplicity, 0);
+				if(ev->involved_actors() > 0)
+					player_events.add(ev, copies);
+				else
+					unassoc_events.add(ev, copies);
+			}
 
-		vector<string> messages;
+			shuffle(players.begin(), players.end(), rng);
+			player_pool.assign(players, world.roster);
+		}
 
-		Round(World &w, mt19937 rng) : world(w), rng(rng) {
-			player_pool.reserve(world.players.size());
-			for(auto &[_, player]: world.players.forward) {
-				Player *ply = &player;
-				player_pool.push_back(ply);
-			}
+		// Every message is rendered into this one buffer, which soon stops
+		// needing to grow
+		pmr::string render_buffer{&arena};
 
-			for(auto &[_, event]: world.events.forward) {
-				Event *ev = &event;
-				for(int i = 0; i < ev->multiplicity; i++)
-					if(ev->involved_actors() > 0)
-						player_events.push_back(ev);
-					else
-						unassoc_events.push_back(ev);
+		const pmr::string &render(Event::Binding &b) {
+			render_buffer.clear();
+			b.event.message.render(render_buffer, b);
+			return render_buffer;
+		}
+
+		// Effects only apply once every event is bound, so the world a
+		// message sees is the same whether it's rendered now or later.
+		void bound(const Event::Binding &b) {
+			bindings.push_back(b);
+			if(narrate && message_sink && threads <= 1) {
+				const pmr::string &message = render(bindings.back());
+				if(!message.empty())
+					*message_sink << message << endl;
 			}
+		}
+
+		enum class Draw { declined, unbound, bound };
 
-			shuffle(player_pool.begin(), player_pool.end(), rng);
-			shuffle(player_events.begin(), player_events.end(), rng);
-			shuffle(unassoc_events.begin(), unassoc_events.end(), rng);
+		// Draws an event from deck and, if it happens, tries to bind it.
+		Draw draw_event(EventDeck &deck, PlayerPool &pool) {
+			Event *ev = deck.draw(rng);
+			EventStats *es = stats ? &stats->events[world.events.get_name(ev)] : nullptr;
+			if(es) es->drawn++;
+			if(!ev->should_happen(rng)) {
+				if(es) es->unlucky++;
+				return Draw::declined;
+			}
+			chrono::steady_clock::time_point start;
+			if(es) start = chrono::steady_clock::now();
+			auto b = Event::Binding::try_bind(*ev, world, pool, true, es, &arena);
+			if(es) es->bind_seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+			if(!b) return Draw::unbound;
+			if(es) es->bound++;
+			bound(*b);
+			return Draw::bound;
 		}
 
 		void cause_player_event() {
 			if(player_pool.empty() || player_events.empty()) return;
 
-			vector<Player *> pool(player_pool);
 			while(!player_events.empty()) {
-				Event *ev = player_events.back();
-				player_events.pop_back();
-				if(!ev->should_happen(rng)) return;
-				auto b = Event::Binding::try_bind(*ev, world, pool);
-				if(b) {
-					bindings.push_back(*b);
-					player_pool = pool;
+				Draw d = draw_event(player_events, player_pool);
+				if(d == Draw::declined) return;
+				if(d == Draw::bound) {
+					player_pool.commit();
 					return;
 				}
 			}
@@ -1250,37 +2921,130 @@ class Round {
 		void cause_unassoc_event() {
 			if(unassoc_events.empty()) return;
 
-			vector<Player *> no_pool;
+			PlayerPool no_pool;
 			while(!unassoc_events.empty()) {
-				Event *ev = unassoc_events.back();
-				unassoc_events.pop_back();
-				if(!ev->should_happen(rng)) return;
-				auto b = Event::Binding::try_bind(*ev, world, no_pool);
-				if(b) {
-					bindings.push_back(*b);
-				}
+				if(draw_event(unassoc_events, no_pool) == Draw::declined) return;
 			}
 		}
 
-		void resolve() {
+		// The phases of a round: events are bound first, against the world as
+		// it stood at the start, then described, then their effects applied.
+		void bind_events() {
+			if(stats) {
+				for(const Event *ev: closed_events)
+					stats->events[world.events.get_name(ev)].world_mismatch++;
+			}
 			while(!player_pool.empty() && !player_events.empty()) {
 				cause_player_event();
 			}
 			while(!unassoc_events.empty()) {
 				cause_unassoc_event();
 			}
+		}
+
+		void render_messages() {
+			if(!narrate) return;
+			if(threads > 1) {
+				for(const pmr::string &message: render_parallel()) {
+					if(message.empty()) continue;
+					if(message_sink) *message_sink << message << endl;
+					else messages.emplace_back(message);
+				}
+				return;
+			}
+			if(message_sink) return;  // already written as bound
 			for(auto &b: bindings) {
-				ostringstream os;
-				os << b;
-				string message = os.str();
+				const pmr::string &message = render(b);
 				if(!message.empty())
-					messages.push_back(message);
+					messages.emplace_back(message);
+			}
+		}
+
+		// Parallel work on bindings is done a block at a time, by whichever
+		// thread comes for the next block
+		static constexpr size_t BLOCK = 64;
+
+		size_t blocks() const { return (bindings.size() + BLOCK - 1) / BLOCK; }
+
+		template<typename F>
+		void for_blocks(F &&work) {
+			atomic<size_t> next_block = 0;
+			atomic<uint64_t> thread_allocs = 0;
+			auto worker = [&]() {
+				for(size_t block; (block = next_block++) < blocks(); )
+					work(block);
+			};
+			vector<thread> pool;
+			for(size_t i = 1; i < min(threads, blocks()); i++) {
+				pool.emplace_back([&]() {
+					worker();
+					thread_allocs += allocations;
+				});
+			}
+			worker();  // this thread takes its share too
+			for(thread &t: pool) t.join();
+			// so that --stats sees what the other threads allocated
+			allocations += thread_allocs;
+		}
+
+		// Rendering only reads the world, and each message goes in its
+		// binding's place, so the order is kept
+		pmr::vector<pmr::string> render_parallel() {
+			pmr::vector<pmr::string> rendered(bindings.size(), &shared_arena);
+			for_blocks([&](size_t block) {
+				for(size_t i = block * BLOCK; i < min((block + 1) * BLOCK, bindings.size()); i++)
+					bindings[i].event.message.render(rendered[i], bindings[i]);
+			});
+			return rendered;
+		}
+
+		void apply_effects() {
+			if(threads > 1) {
+				apply_effects_parallel();
+				return;
 			}
 			for(auto &b: bindings) {
-				b.cause_effects(world);
+				b.cause_effects(world, changes);
 			}
 		}
 
+		// Bindings never share players, so each block of them changes its
+		// own players into a log of its own. What they do to the world and
+		// relations, which they do share, is then done in binding order.
+		void apply_effects_parallel() {
+			vector<vector<string>> world_adds(bindings.size());
+			vector<ChangeLog> logs(changes ? blocks() : 0);
+			for_blocks([&](size_t block) {
+				ChangeLog *log = changes ? &logs[block] : nullptr;
+				for(size_t i = block * BLOCK; i < min((block + 1) * BLOCK, bindings.size()); i++)
+					bindings[i].cause_player_effects(log, world_adds[i]);
+			});
+			for(const ChangeLog &log: logs) changes->merge(log);
+			for(size_t i = 0; i < bindings.size(); i++)
+				bindings[i].cause_world_effects(world, world_adds[i], changes);
+		}
+
+		void resolve() {
+			if(!stats) {
+				bind_events();
+				render_messages();
+				apply_effects();
+				return;
+			}
+			auto timed = [](auto &&phase, double &seconds, uint64_t &allocs) {
+				uint64_t allocs_before = allocations;
+				auto start = chrono::steady_clock::now();
+				phase();
+				seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+				allocs += allocations - allocs_before;
+			};
+			stats->rounds++;
+			timed([this]() { bind_events(); }, stats->bind_seconds, stats->bind_allocs);
+			timed([this]() { render_messages(); }, stats->render_seconds, stats->render_allocs);
+			timed([this]() { apply_effects(); }, stats->effects_seconds, stats->effects_allocs);
+		}
+
+
 		friend ostream &operator<<(ostream &os, Round &r) {
 			for(auto &s: r.messages) {
 				os << s << endl;
@@ -1289,6 +3053,339 @@ class Round {
 		}
 };
 
+void ChangeLog::write(ostream &os, const World &w, bool with_world) const {
+	class PlayerChanges {
+		public:
+			set<string> attr_removes, attr_adds, prop_removes, prop_adds;
+	};
+	// Grouped and sorted by name, as diff would have them
+	map<string, PlayerChanges> players;
+	PlayerChanges world;
+	auto changes_of = [&](Player *p) -> PlayerChanges & {
+		return p == &w.world_player ? world : players[w.players.get_name(p)];
+	};
+	for(const auto &[key, change]: attrs) {
+		if(change.first == change.second) continue;
+		PlayerChanges &pc = changes_of(key.first);
+		(change.second ? pc.attr_adds : pc.attr_removes).insert(key.second);
+	}
+	for(const auto &[key, change]: props) {
+		if(change.first == change.second) continue;
+		PlayerChanges &pc = changes_of(key.first);
+		if(change.first) pc.prop_removes.insert(key.second + ":" + *change.first);
+		if(change.second) pc.prop_adds.insert(key.second + ":" + *change.second);
+	}
+	auto write_player = [&os](const string &id, const PlayerChanges &pc) {
+		for(const string &s: pc.attr_removes) os << id << "[-" << s << "]" << endl;
+		for(const string &s: pc.attr_adds) os << id << "[+" << s << "]" << endl;
+		for(const string &s: pc.prop_removes) os << id << "[-" << s << "]" << endl;
+		for(const string &s: pc.prop_adds) os << id << "[+" << s << "]" << endl;
+	};
+	for(const auto &[id, pc]: players)
+		write_player(id, pc);
+
+	map<string, pair<set<string>, set<string>>> relations;  // removed, added
+	for(const auto &[key, change]: edges) {
+		if(change.first == change.second) continue;
+		const auto &[rel, left, right] = key;
+		string name = w.relations.get_name(rel);
+		auto &[removed, added] = relations[name];
+		(change.second ? added : removed).insert(w.players.get_name(left) + ":" + name + ":" + w.players.get_name(right));
+	}
+	for(const auto &[_, change]: relations) {
+		for(const string &e: change.first) os << "-" << e << endl;
+		for(const string &e: change.second) os << "+" << e << endl;
+	}
+
+	if(with_world) write_player(w.world_player.name, world);
+}
+
+bool ChangeLog::apply(World &w, string_view line) {
+	if(line.starts_with('+') || line.starts_with('-')) {
+		bool add = line.front() == '+';
+		line.remove_prefix(1);
+		size_t first = line.find(':');
+		size_t second = first == string_view::npos ? first : line.find(':', first + 1);
+		if(second == string_view::npos) return false;
+		Player *left = w.players.get(line.substr(0, first));
+		Relation *rel = w.relations.get(line.substr(first + 1, second - first - 1));
+		Player *right = w.players.get(line.substr(second + 1));
+		if(!left || !rel || !right) return false;
+		if(add) rel->insert(left, right);
+		else rel->erase(left, right);
+		return true;
+	}
+
+	size_t open = line.find('[');
+	if(open == string_view::npos || !line.ends_with(']') || line.size() - open < 4) return false;
+	string_view id = line.substr(0, open);
+	Player *p = id == w.world_player.name ? &w.world_player : w.players.get(id);
+	if(!p) return false;
+	w.matches.touch(p);
+	string_view spec = line.substr(open + 1, line.size() - open - 2);
+	bool add = spec.front() == '+';
+	if(!add && spec.front() != '-') return false;
+	spec.remove_prefix(1);
+	auto colon = spec.find(':');
+	if(colon == string_view::npos) {
+		string attr(spec);
+		size_t sym = w.attr_symbols.intern(attr);
+		if(add) p->insert_attr(attr, sym);
+		else p->erase_attr(attr, sym);
+	} else {
+		string key(spec.substr(0, colon));
+		if(add) p->props.insert_or_assign(key, string(spec.substr(colon + 1)));
+		else p->props.erase(key);
+	}
+	return true;
+}
+
+// Loads a journal: a checkpoint world ending in ---, then each round's
+// changes (in ChangeLog notation) after an "@round N" line. Rounds after
+// upto, if given, are left out. Returns the last round applied (0 for just
+// the checkpoint), or nothing if the journal is malformed.
+optional<size_t> replay_journal(World &w, string_view data, optional<size_t> upto) {
+	TextReader in(data);
+	w.read(in);
+	size_t round = 0;
+	while(in.ok) {
+		in.skip_ws();
+		if(in.at_end()) break;
+		size_t at = in.mark();
+		string_view line = in.line();
+		if(line.starts_with("@round ")) {
+			size_t n;
+			if(from_chars(line.data() + 7, line.data() + line.size(), n).ec != errc()) {
+				in.error("bad round number", at);
+				break;
+			}
+			if(upto && n > *upto) break;
+			round = n;
+		} else if(!ChangeLog::apply(w, line)) {
+			in.error("can't apply " + string(line), at);
+		}
+	}
+	if(!in.ok) return optional<size_t>();
+	return round;
+}
+
+optional<size_t> load_journal(World &w, const string &path, optional<size_t> upto = optional<size_t>()) {
+	ifstream f(path);
+	int fd = open(path.c_str(), O_RDONLY);
+	if(!f || fd < 0) {
+		if(fd >= 0) close(fd);
+		cerr << "couldn't open journal " << path << endl;
+		return optional<size_t>();
+	}
+	optional<size_t> last;
+	{
+		InputBuffer buf(fd, f);
+		last = replay_journal(w, buf.view(), upto);
+	}
+	close(fd);
+	return last;
+}
+
+void MatchCache::build(World &w) {
+	entries.clear();
+	dirty.clear();
+	dirty_flags.assign(w.players.size(), false);
+	roster = &w.roster;
+	retire = w.retire ? &*w.retire : nullptr;
+	vector<Player *> players;
+	players.reserve(w.players.size());
+	for(auto &[_, ply]: w.players.by_name()) players.push_back(&ply);
+	roster->assign(players, [this](const Player *p) { return retire && retire->applies_to(p); });
+
+	// Specs that match alike share an entry. Events often share a spec
+	// (see World::intern_spec), which then needs looking at only once.
+	for(Event::ActorSpec &spec: w.specs) spec.match_entry.reset();
+	using Key = tuple<const set<string> &, const set<string> &, const map<string, string> &, const map<string, string> &>;
+	map<Key, size_t> distinct;
+	for(auto &[_, event]: w.events.by_name()) {
+		for(auto &[_, need]: event.actors.by_name()) {
+			Event::ActorSpec &spec = *need;
+			if(spec.match_entry) continue;
+			Key key(spec.attr_matches, spec.attr_neg_matches, spec.prop_matches, spec.prop_neg_matches);
+			auto [it, fresh] = distinct.try_emplace(key, entries.size());
+			if(fresh) add_entry(spec, false);
+			spec.match_entry = it->second;
+		}
+	}
+}
+
+void MatchCache::add_entry(const Event::ActorSpec &spec, bool with_retired) {
+	Entry e;
+	e.with_retired = with_retired;
+	e.bits.assign((roster->size() + 63) / 64, 0);
+	uint32_t end = with_retired ? roster->size() : roster->live_places();
+	for(uint32_t place = 0; place < end; place++)
+		e.set(place, spec.applies_to(roster->at(place)));
+	entries.push_back({&spec, move(e)});
+}
+
+void MatchCache::watch(Event::ActorSpec &spec) {
+	spec.match_entry = entries.size();
+	add_entry(spec, true);
+}
+
+vector<Player *> MatchCache::matching(const Event::ActorSpec &spec) const {
+	vector<Player *> found;
+	for_each(entries[*spec.match_entry].second, [&](Player *p) { found.push_back(p); });
+	roster->sort_by_name(found);
+	return found;
+}
+
+void MatchCache::refresh() {
+	for(Player *p: dirty) {
+		dirty_flags[p->index] = false;
+		bool live = !(retire && retire->applies_to(p));
+		uint32_t place = roster->place(p);
+		if(live != roster->is_live(p)) {
+			uint32_t to = roster->cross(p);
+			for(auto &[_, e]: entries) e.swap(place, to);
+			place = to;
+		}
+		for(auto &[spec, e]: entries) e.set(place, (live || e.with_retired) && spec->applies_to(p));
+	}
+	dirty.clear();
+}
+
+Player *MatchCache::first(const Event::ActorSpec &spec, const PlayerPool &pool) const {
+	if(!spec.match_entry) {
+		for(Player *p: pool)
+			if(spec.applies_to(p)) return p;
+		return nullptr;
+	}
+	const Entry &e = entries[*spec.match_entry].second;
+	// A scan of the pool expects to go about size / count players before a
+	// match; when that's further than there are matches, try them all.
+	if(e.count * e.count < pool.size()) {
+		Player *best = nullptr;
+		for_each(e, [&](Player *p) {
+				if(pool.is_free(p) && (!best || pool.rank_of(p) < pool.rank_of(best))) best = p;
+		});
+		return best;
+	}
+	for(Player *p: pool)
+		if(e.has(roster->place(p))) return p;
+	return nullptr;
+}
+
+void MatchCache::all(const Event::ActorSpec &spec, const PlayerPool &pool, pmr::vector<Player *> &into) const {
+	if(!spec.match_entry) {
+		for(Player *p: pool)
+			if(spec.applies_to(p)) into.push_back(p);
+		return;
+	}
+	const Entry &e = entries[*spec.match_entry].second;
+	// Sorting a few matches beats scanning the whole pool
+	if(e.count * 16 < pool.size()) {
+		for_each(e, [&](Player *p) {
+				if(pool.is_free(p)) into.push_back(p);
+		});
+		sort(into.begin(), into.end(), [&pool](const Player *a, const Player *b) {
+				return pool.rank_of(a) < pool.rank_of(b);
+		});
+		return;
+	}
+	// at most e.count players match, so they can be written in place
+	size_t n = into.size();
+	into.resize(n + e.count);
+	Player **out = into.data() + n;
+	for(Player *p: pool)
+		if(e.has(roster->place(p))) *out++ = p;
+	into.resize(out - into.data());
+}
+
+// Reads an ActorSpec given as an argument, reporting whether it was valid
+bool read_filter(const string &spec, World &w, Event::ActorSpec &filter) {
+	TextReader in(spec);
+	filter.read(in, w);
+	return in.ok;
+}
+
+// Rounds are played until at most winners players match the filter, or
+// max_rounds have been played if that's nonzero.
+class Game {
+	public:
+		World &world;
+		Event::ActorSpec filter;
+		size_t winners;
+		mt19937 rng;
+		size_t rounds = 0;
+		size_t max_rounds = 0;
+		// If set, each round's messages and changes are printed here
+		ostream *log = nullptr;
+		// If set, each round's changes are appended here as a journal
+		ostream *journal = nullptr;
+		RoundStats *stats = nullptr;
+		size_t threads = 1;
+		map<const Event *, size_t> fired;
+
+		// A game on w, or null (with the error reported) if filter_spec
+		// can't be read. The world keeps a pointer to the filter, so a Game
+		// stays where it's made.
+		static unique_ptr<Game> start(World &w, const string &filter_spec, size_t winners, mt19937 seeded) {
+			unique_ptr<Game> game(new Game(w, winners, seeded));
+			if(!read_filter(filter_spec, w, game->filter)) return nullptr;
+			w.matches.watch(game->filter);
+			return game;
+		}
+
+		vector<pair<string, const Player *>> remaining() {
+			world.matches.refresh();
+			vector<pair<string, const Player *>> left;
+			for(const Player *ply: world.matches.matching(filter))
+				left.push_back({world.players.get_name(ply), ply});
+			return left;
+		}
+
+		// Only the players changed since the last round are looked at
+		bool finished() {
+			world.matches.refresh();
+			return world.matches.count(filter) <= winners;
+		}
+
+		void play_round() {
+			rounds++;
+			Round r(world, mt19937(rng()));
+			r.stats = stats;
+			r.threads = threads;
+			ChangeLog changes;
+			if(log || journal) r.changes = &changes;
+			if(log) {
+				*log << "Round " << rounds << endl;
+				*log << "---" << endl;
+				r.message_sink = log;
+			} else {
+				r.narrate = false;
+			}
+			r.resolve();
+			for(const auto &b: r.bindings)
+				fired[&b.event]++;
+			if(journal) {
+				*journal << "@round " << rounds << endl;
+				changes.write(*journal, world);
+			}
+			if(log) {
+				*log << endl;
+				changes.write(*log, world, false);
+				*log << endl;
+			}
+		}
+
+		// Returns the players left matching the filter
+		vector<pair<string, const Player *>> play() {
+			while(!finished() && !(max_rounds && rounds >= max_rounds))
+				play_round();
+			return remaining();
+		}
+
+	private:
+		Game(World &w, size_t winners, mt19937 seeded) : world(w), winners(winners), rng(seeded) {}
+};
+
 ostream &Player::write(ostream &os, const World &w) const {
 	os << name << "(";
 	string p = w.pronouns.get_name(pro);
@@ -1302,44 +3399,46 @@ ostream &Player::write(ostream &os, const World &w) const {
 	return os;
 }
 
-istream &Player::read(istream &is, World &w) {
-	if(!getline(is, name, '(')) return is;
-	string pkey;
-	if(!getline(is, pkey, ')')) return is;
+void Player::read(TextReader &in, World &w) {
+	name = in.until('(');
+	size_t at = in.mark();
+	string_view pkey = in.until(')');
+	if(!in.ok) return;
 	pro = w.pronouns.get(pkey);
+	if(!pro) in.warn("no pronouns named " + string(pkey), at);
 
-	attrs.clear();
+	clear_attrs();
 	props.clear();
-	is >> ws;
-	if(is.peek() == '[') {
-		vector list = list_of_strings(is);
-		if(!is) return is;
-		for(const string &attr: list) {
+	in.skip_ws();
+	if(in.peek() == '[') {
+		for(string_view attr: in.list()) {
 			auto colon = attr.find(':');
-			if(colon != string::npos) {
-				const string name = attr.substr(0, colon);
-				const string value = attr.substr(colon + 1);
+			if(colon != string_view::npos) {
+				string_view name = attr.substr(0, colon);
+				string_view value = attr.substr(colon + 1);
 				if(!(name.empty() || value.empty())) {
-					props.insert_or_assign(name, value);
+					props.insert_or_assign(string(name), string(value));
 				}
 			} else {
-				attrs.insert(attr);
+				string a(attr);
+				insert_attr(a, w.attr_symbols.intern(a));
 			}
 		}
 	}
-
-	return is;
 }
 
 void Player::diff(Player *to, ostream &os, const World &w, const World &nw) {
+	diff(*to, os, w.players.get_name(this), nw.players.get_name(to));
+}
+
+void Player::diff(const Player &to, ostream &os, const string &me, const string &them) const {
 	set<string> add, rem;
-	string me = w.players.get_name(this), them = nw.players.get_name(to);
-	asym_diff(attrs, to->attrs, add, rem);
+	asym_diff(attrs, to.attrs, add, rem);
 	for(const string &removed: rem) os << me << "[-" << removed << "]" << endl;
 	for(const string &added: add) os << them << "[+" << added << "]" << endl;
 	set<string> myprops, theirprops;
 	for(const auto &[k, v]: props) myprops.insert(k + ":" + v);
-	for(const auto &[k, v]: to->props) theirprops.insert(k + ":" + v);
+	for(const auto &[k, v]: to.props) theirprops.insert(k + ":" + v);
 	asym_diff(myprops, theirprops, add, rem);
 	for(const string &removed: rem) os << me << "[-" << removed << "]" << endl;
 	for(const string &added: add) os << me << "[+" << added << "]" << endl;
@@ -1355,71 +3454,68 @@ ostream &Relation::write(ostream &os, const World &w) const {
 		os << " reflex";
 	}
 	os << " {" << endl;
-	for(const auto &[lp, rp]: edges) {
-		const string lname = w.players.get_name(lp), rname = w.players.get_name(rp);
-		if(!(lname.empty() || rname.empty())) {
-			os << "    " << lname << " " << rname << endl;
-		}
-	}
+	for_each_edge([&](const Player *lp, const Player *rp) {
+			const string lname = w.players.get_name(lp), rname = w.players.get_name(rp);
+			if(!(lname.empty() || rname.empty())) {
+				os << "    " << lname << " " << rname << endl;
+			}
+	});
 	os << "  }";
 	return os;
 }
 
-istream &Relation::read(istream &is, World &w) {
-	string dir;
-	if(!(is >> dir)) return is;
+void Relation::read(TextReader &in, World &w) {
+	string_view dir = in.word();
 	if(dir == "dir")
 		directional = true;
 	else if(dir == "undir")
 		directional = false;
-	else {
-		is.setstate(ios_base::failbit);
-		return is;
-	}
+	else
+		return in.error("expected dir or undir");
 	allow_reflex = false;
-	is >> ws;
-	if(is.peek() != '{') {
-		string token;
-		if(!(is >> token)) return is;
-		if(token == "reflex") {
-			allow_reflex = true;
-		} else {
-			is.setstate(ios_base::failbit);
-			return is;
-		}
-		is >> ws;
-		if(is.peek() != '{') {
-			is.setstate(ios_base::failbit);
-			return is;
-		}
+	in.skip_ws();
+	if(in.peek() != '{') {
+		if(in.word() != "reflex") return in.error("expected reflex or '{'");
+		allow_reflex = true;
+		in.skip_ws();
 	}
-	is.get();
-
-	while(true) {
-		string left, right;
-		is >> left;
+	if(!in.eat('{')) return in.error("expected '{'");
+
+	adjacency.clear();
+	edge_count = 0;
+	use_matrix(w.players.size());
+	while(in.ok) {
+		in.skip_ws();
+		size_t at = in.mark();
+		string_view left = in.word();
 		if(left == "}") break;
-		is >> right;
+		if(left.empty()) return in.error("expected '}'");
+		string_view right = in.word();
+		if(right.empty() || right == "}") return in.error("expected a pair of players");
 		Player *lp = w.players.get(left), *rp = w.players.get(right);
 		if(!lp) {
-			cerr << "bad player name " << left << " in relation" << endl;
+			in.warn("bad player name " + string(left) + " in relation", at);
 		}
 		if(!rp) {
-			cerr << "bad player name " << right << " in relation" << endl;
+			in.warn("bad player name " + string(right) + " in relation", at);
 		}
 		if(!lp || !rp) continue;
 		insert(lp, rp);
 	}
-	return is;
 }
 
 void Relation::diff(Relation *to, ostream &os, const World &w, const World &nw) {
+	diff(*to, os, w.relations.get_name(this), nw.relations.get_name(to), w, nw);
+}
+
+void Relation::diff(const Relation &to, ostream &os, const string &me, const string &them, const World &w, const World &nw) const {
 	set<string> mine, theirs, add, rem;
-	string me = w.relations.get_name(this), them = nw.relations.get_name(to);
-	for(const auto &[lp, rp]: edges)
-		mine.insert(w.players.get_name(lp) + ":" + me + ":" + w.players.get_name(rp));
-	for(const auto &[lp, rp]: to->edges)
-		theirs.insert(nw.players.get_name(lp) + ":" + them + ":" + nw.players.get_name(rp));
+	for_each_edge([&](const Player *lp, const Player *rp) {
+			mine.insert(w.players.get_name(lp) + ":" + me + ":" + w.players.get_name(rp));
+	});
+	to.for_each_edge([&](const Player *lp, const Player *rp) {
+			theirs.insert(nw.players.get_name(lp) + ":" + them + ":" + nw.players.get_name(rp));
+	});
 	asym_diff(mine, theirs, add, rem);
 	for(const string &removed: rem) os << "-" << removed << endl;
 	for(const string &added: add) os << "+" << added << endl;
@@ -1428,74 +3524,811 @@ void Relation::diff(Relation *to, ostream &os, const World &w, const World &nw)
 ostream &Event::write(ostream &os, const World &w) const {
 	os << "{ needs ";
 	actors.write(os, w, "    ", "  ");
-	os << " world " << world_spec << " rel " << rel << " chance " << multiplicity << "/" << unlikeliness << " message {";
-	for(const auto &r: render)
-		r->write(os, w);
+	os << " world " << *world_spec << " rel " << rel << " chance " << multiplicity << "/" << unlikeliness << " message {";
+	message.write(os);
 	os << "} }" << endl;
 	return os;
 }
 
-istream &Event::read(istream &is, World &w) {
-	if(is.peek() != '{') {
-		is.setstate(ios_base::failbit);
-		return is;
-	}
-	is.get();
+void Event::read(TextReader &in, World &w) {
+	if(!in.eat('{')) return in.error("expected '{'");
 
 	actors.clear();
-	world_spec.clear();
-	render.clear();
-
-	string section;
-	while(true) {
-		is >> ws;
-		if(is.peek() == '}') {
-			is.get();
-			is >> ws;
-			break;
-		}
+	world_spec = SpecRef();
+	message = Message();
 
-		if(!(is >> section)) break;
+	while(in.ok) {
+		in.skip_ws();
+		if(in.eat('}')) break;
+
+		size_t at = in.mark();
+		string_view section = in.word();
 		if(section == "needs") {
-			actors.read(is, w);
+			actors.read(in, w);
 		} else if(section == "world") {
-			is >> ws;
-			is >> world_spec;
+			in.skip_ws();
+			world_spec.read(in, w);
 		} else if(section == "chance") {
-			is >> multiplicity;
-			is >> ws;
-			if(is.peek() == '/') {
-				is.get();
-				is >> unlikeliness;
-				is >> ws;
-			}
+			// A part that isn't a number keeps its default, as the old
+			// reader never refused one
+			auto part = [&in](int &value) {
+				in.skip_ws();
+				size_t at = in.mark();
+				if(optional<int> n = in.integer()) {
+					value = *n;
+				} else {
+					in.skip_value();
+					in.warn("ignoring chance " + string(in.view(at)) + ", which isn't a number", at);
+				}
+			};
+			part(multiplicity);
+			in.skip_ws();
+			if(in.eat('/')) part(unlikeliness);
 		} else if(section == "rel") {
-			is >> ws;
-			is >> rel;
+			rel.read(in);
 		} else if(section == "message") {
-			is >> ws;
-			if(is.peek() != '{') {
-				is.setstate(ios_base::failbit);
-				return is;
+			in.skip_ws();
+			if(!in.eat('{')) return in.error("expected '{'");
+			string_view message = in.until('}');
+			this->message = Message(message);
+		} else if(section.empty()) {
+			return in.error("expected '}'");
+		} else {
+			// Skipped, so that the rest of the event still reads
+			in.skip_value();
+			in.warn("ignoring unknown event section " + string(section), at);
+		}
+	}
+}
+
+void Event::Template::write_bin(BinWriter &out) const {
+	out.str(source);
+	out.u8(plain());
+	if(plain()) out.str(text);
+	else program->write_bin(out);
+}
+
+void Event::Template::read_bin(BinReader &in) {
+	source = in.str();
+	text.clear();
+	program.reset();
+	if(in.u8()) {
+		text = in.str();
+	} else {
+		program = make_unique<Message>();
+		program->read_bin(in);
+	}
+}
+
+void Event::ActorSpec::write_bin(BinWriter &out, const World &w) const {
+	for(const set<string> *attrs: {&attr_matches, &attr_neg_matches, &attr_adds, &attr_removes})
+		out.strs(attrs->begin(), attrs->end());
+	for(const map<string, string> *props: {&prop_matches, &prop_neg_matches}) {
+		out.u32(props->size());
+		for(const auto &[key, val]: *props) {
+			out.str(key);
+			out.str(val);
+		}
+	}
+	for(const map<string, Template> *props: {&prop_adds, &prop_removes}) {
+		out.u32(props->size());
+		for(const auto &[key, val]: *props) {
+			out.str(key);
+			val.write_bin(out);
+		}
+	}
+}
+
+void Event::ActorSpec::read_bin(BinReader &in, World &w) {
+	clear();
+	for(set<string> *attrs: {&attr_matches, &attr_neg_matches, &attr_adds, &attr_removes})
+		in.strs(*attrs);
+	for(map<string, string> *props: {&prop_matches, &prop_neg_matches}) {
+		uint32_t count = in.u32();
+		for(uint32_t i = 0; in.ok && i < count; i++) {
+			string key = in.str();
+			props->insert_or_assign(key, in.str());
+		}
+	}
+	for(map<string, Template> *props: {&prop_adds, &prop_removes}) {
+		uint32_t count = in.u32();
+		for(uint32_t i = 0; in.ok && i < count; i++) {
+			string key = in.str();
+			Template val;
+			val.read_bin(in);
+			props->insert_or_assign(key, move(val));
+		}
+	}
+	compile(w);
+}
+
+void Player::write_bin(BinWriter &out, const World &w) const {
+	out.str(name);
+	out.str(w.pronouns.get_name(pro));
+	out.strs(attrs.begin(), attrs.end());
+	out.u32(props.size());
+	for(const auto &[key, val]: props) {
+		out.str(key);
+		out.str(val);
+	}
+}
+
+void Player::read_bin(BinReader &in, World &w) {
+	name = in.str();
+	pro = w.pronouns.get(in.str());
+	clear_attrs();
+	props.clear();
+	uint32_t count = in.u32();
+	for(uint32_t i = 0; in.ok && i < count; i++) {
+		string attr = in.str();
+		insert_attr(attr, w.attr_symbols.intern(attr));
+	}
+	count = in.u32();
+	for(uint32_t i = 0; in.ok && i < count; i++) {
+		string key = in.str();
+		props.insert_or_assign(key, in.str());
+	}
+}
+
+void Relation::write_bin(BinWriter &out, const World &w) const {
+	out.u8(directional);
+	out.u8(allow_reflex);
+	out.u32(edge_count);
+	for_each_edge([&out](const Player *lp, const Player *rp) {
+			out.u32(out.player_ordinals[lp->index]);
+			out.u32(out.player_ordinals[rp->index]);
+	});
+}
+
+void Relation::read_bin(BinReader &in, World &w) {
+	directional = in.u8();
+	allow_reflex = in.u8();
+	adjacency.clear();
+	edge_count = 0;
+	use_matrix(w.players.size());
+	uint32_t count = in.u32();
+	for(uint32_t i = 0; in.ok && i < count; i++) {
+		Player *lp = in.player(), *rp = in.player();
+		if(lp && rp) insert(lp, rp);
+	}
+}
+
+void Event::write_bin(BinWriter &out, const World &w) const {
+	actors.write_bin(out, w);
+	world_spec.write_bin(out, w);
+	rel.write_bin(out);
+	out.i32(multiplicity);
+	out.i32(unlikeliness);
+	message.write_bin(out);
+}
+
+void Event::read_bin(BinReader &in, World &w) {
+	actors.read_bin(in, w);
+	world_spec.read_bin(in, w);
+	rel.read_bin(in);
+	multiplicity = in.i32();
+	unlikeliness = in.i32();
+	message.read_bin(in);
+}
+
+void World::write_binary(ostream &os) const {
+	BinWriter out;
+	out.player_ordinals.assign(players.size(), 0);
+	uint32_t ordinal = 0;
+	for(const auto &[_, ply]: players.by_name()) out.player_ordinals[ply.index] = ordinal++;
+
+	pronouns.write_bin(out, *this);
+	players.write_bin(out, *this);
+	relations.write_bin(out, *this);
+	out.strs(world_player.attrs.begin(), world_player.attrs.end());
+	out.u32(world_player.props.size());
+	for(const auto &[key, val]: world_player.props) {
+		out.str(key);
+		out.str(val);
+	}
+	out.u8(retire.has_value());
+	if(retire) retire->write_bin(out, *this);
+	events.write_bin(out, *this);
+	out.finish(os);
+}
+
+bool World::read_binary(string_view data) {
+	clear();
+	BinReader in(data);
+	pronouns.read_bin(in, *this);
+	players.read_bin(in, *this);
+	for(auto &[_, ply]: players.by_name()) in.players.push_back(&ply);
+	relations.read_bin(in, *this);
+	uint32_t count = in.u32();
+	for(uint32_t i = 0; in.ok && i < count; i++) {
+		string attr = in.str();
+		world_player.insert_attr(attr, attr_symbols.intern(attr));
+	}
+	count = in.u32();
+	for(uint32_t i = 0; in.ok && i < count; i++) {
+		string key = in.str();
+		world_player.props.insert_or_assign(key, in.str());
+	}
+	if(in.u8()) {
+		retire.emplace();
+		retire->read_bin(in, *this);
+	}
+	events.read_bin(in, *this);
+	if(!in.ok) {
+		cerr << "binary world is truncated or corrupt" << endl;
+		return false;
+	}
+	return link();
+}
+
+// Reads a world in either format; binary worlds are recognized by their
+// magic number. fd must refer to the same input as is.
+bool read_world(World &w, istream &is, int fd) {
+	InputBuffer in(fd, is);
+	string_view data = in.view();
+	if(data.starts_with(BIN_MAGIC[0])) return w.read_binary(data);
+	TextReader text(data);
+	w.read(text);
+	return text.ok;
+}
+
+void write_world(ostream &os, const World &w, bool binary) {
+	if(binary) w.write_binary(os);
+	else os << w;
+}
+
+// Binds the named event to players given as needid:playerid, for
+// try_event, saying what's wrong if they don't make a whole binding
+optional<Event::Binding> bind_by_hand(World &w, const string &evid, span<const string> pairs) {
+	Event *ev_found = w.events.get(evid);
+	if(!ev_found) {
+		cerr << "no event named " << evid << "; the events are [";
+		auto events = w.events.by_name();
+		write_joined(cerr, events.begin(), events.end(), [](const auto &pair) {
+				return pair.first;
+		});
+		cerr << "]" << endl;
+		return optional<Event::Binding>();
+	}
+	Event &ev = *ev_found;
+	if(pairs.size() != ev.involved_actors()) {
+		cerr << "event expects " << ev.involved_actors() << " actors; you supplied " << pairs.size() << endl;
+		return optional<Event::Binding>();
+	}
+	Event::Binding binding(ev);
+	for(const string &pair: pairs) {
+		auto pos = pair.find(':');
+		if(pos == string::npos) {
+			cerr << "needid:playerid spec " << pair << " is invalid--need a colon" << endl;
+			return optional<Event::Binding>();
+		}
+		string needid = pair.substr(0, pos);
+		string playerid = pair.substr(pos + 1);
+		optional<size_t> slot = ev.slot_of(needid);
+		if(!slot) {
+			cerr << "event does not contain a needid " << needid << endl;
+			return optional<Event::Binding>();
+		}
+		Player *p = w.players.get(playerid);
+		if(!p) {
+			cerr << "no such playerid " << playerid << endl;
+			return optional<Event::Binding>();
+		}
+		binding[*slot] = p;
+	}
+	for(const auto &[needid, _]: ev.actors.by_name()) {
+		if(!binding[*ev.slot_of(needid)]) {
+			cerr << "no player given for needid " << needid << endl;
+			return optional<Event::Binding>();
+		}
+	}
+	return make_optional(binding);
+}
+
+// Writes the id and name of every player matching spec, or of them all
+bool list_players(ostream &os, World &w, const optional<string> &spec) {
+	optional<Event::ActorSpec> filter;
+	if(spec) {
+		Event::ActorSpec as;
+		if(!read_filter(*spec, w, as)) return false;
+		filter = move(as);
+	}
+	for(const auto &[id, ply]: w.players.by_name()) {
+		if(filter.has_value() && !filter->applies_to(&ply)) continue;
+		os << id << " " << ply.name << endl;
+	}
+	return true;
+}
+
+// The size of a generated world
+struct WorldShape {
+	size_t players = 1000;
+	size_t events = 20;
+	size_t relations = 2;
+	double density = 2;  // mean edges per player in each relation
+};
+
+// Writes a random world in the text format. The events cycle through the
+// kinds described in the README: lone actors, fights and deaths, attributes
+// and properties, world state and (when there are any) relations.
+void generate_world(ostream &os, const WorldShape &shape, mt19937 &rng) {
+	static constexpr size_t TRAITS = 8;
+	static const char *const pronouns[] = {"female", "male", "nonbin"};
+	static const char *const weapons[] = {"knife", "bow", "gun", "club"};
+	uniform_real_distribution<double> unit(0, 1);
+
+	os << "pronouns {" << endl;
+	os << "  female: she her her herself sing" << endl;
+	os << "  male: he him his himself sing" << endl;
+	os << "  nonbin: they them their themself nb" << endl;
+	os << "}" << endl;
+
+	os << "players {" << endl;
+	for(size_t i = 0; i < shape.players; i++) {
+		vector<string> specs;
+		for(size_t t = 0; t < TRAITS; t++) {
+			if(unit(rng) < 0.2) specs.push_back("trait" + to_string(t));
+		}
+		if(unit(rng) < 0.3) specs.push_back(string("weapon:") + weapons[rng() % 4]);
+		os << "  p" << i << ": Player " << i << "(" << pronouns[rng() % 3] << ")[";
+		write_joined(os, specs.begin(), specs.end());
+		os << "]" << endl;
+	}
+	os << "}" << endl;
+
+	os << "relations {" << endl;
+	for(size_t r = 0; r < shape.relations; r++) {
+		os << "  rel" << r << ": " << (r % 2 ? "undir" : "dir") << " {" << endl;
+		if(shape.players > 1) {
+			uniform_int_distribution<size_t> pick(0, shape.players - 1);
+			size_t edges = shape.density * shape.players;
+			for(size_t e = 0; e < edges; e++) {
+				size_t a = pick(rng), b = pick(rng);
+				if(a != b) os << "    p" << a << " p" << b << endl;
+			}
+		}
+		os << "  }" << endl;
+	}
+	os << "}" << endl;
+
+	os << "world [day, hot]" << endl;
+	os << "retire [dead]" << endl;
+
+	os << "events {" << endl;
+	// Enough multiplicity that a round involves most of the players
+	size_t k = max<size_t>(1, shape.players / (4 * max<size_t>(1, shape.events)));
+	for(size_t i = 0; i < shape.events; i++) {
+		string t = "trait" + to_string(i % TRAITS);
+		string r = "rel" + to_string(shape.relations ? i % shape.relations : 0);
+		os << "  e" << i << ": { ";
+		// the last four kinds need a relation
+		switch(i % (shape.relations ? 11 : 7)) {
+			case 0:
+				os << "needs { a: [!dead] } chance " << 4 * k << " message {$a wander[sing=s] around.}";
+				break;
+			case 1:
+				os << "needs { a: [!dead] b: [!dead] } chance " << 3 * k << " message {$a bludgeon[sing=s] $<b>.}";
+				break;
+			case 2:
+				os << "needs { a: [!dead, " << t << "] b: [!dead, !" << t << "]+[dead] } chance " << 2 * k << "/2 message {$a crush[sing=s] $<b><'s> skull.}";
+				break;
+			case 3:
+				os << "needs { a: [!dead, weapon:] b: [!dead]+[dead] } chance " << k << " message {$a kill[sing=s] $<b> with <(a)p> $<a.weapon>.}";
+				break;
+			case 4:
+				os << "needs { a: [!dead] } world [hot] chance " << 2 * k << " message {$a find[sing=s] nobody, but <s> suffer[sing=s] in the heat.}";
+				break;
+			case 5:
+				os << "world [day]+[night]-[day] message {The sun sets.}";
+				break;
+			case 6:
+				os << "world [night]+[day]-[night] message {The sun rises.}";
+				break;
+			case 7:
+				os << "needs { a: [!dead, weapon:]-[weapon:] b: [!dead, !weapon:]+[weapon:$<a.weapon>] } rel { a:" << r << ":b } chance " << k << " message {$a give[sing=s] $b <(a)p> $<a.weapon>.}";
+				break;
+			case 8:
+				os << "needs { a: [!dead] b: [!dead] } rel { !a:" << r << ":b +a:" << r << ":b } chance " << k << " message {$a and $b have grown fond of each other.}";
+				break;
+			case 9:
+				os << "needs { a: [!dead] b: [!dead]+[dead] } rel { a:" << r << ":b -a:" << r << ":b } chance " << k << " message {$a finally get[sing=s] revenge on $<b>.}";
+				break;
+			case 10:
+				os << "needs { a: [!dead] b: [!dead] c: [!dead] } rel { a:" << r << ":c b:" << r << ":c !a:" << r << ":b +a:" << r << ":b } chance " << k << " message {$<a> and $<b> team up against $<c>.}";
+				break;
+		}
+		os << " }" << endl;
+	}
+	os << "}" << endl;
+}
+
+// Times loading a generated world and running a round on it, phase by
+// phase, once for each player count in scales. Each phase's best and mean
+// time over reps repetitions is printed as a line of JSON.
+void run_bench(ostream &os, WorldShape shape, const vector<size_t> &scales, size_t reps, uint32_t seed, size_t threads) {
+	using clock = chrono::steady_clock;
+	static const char *const phases[] = {"parse", "bind", "render", "effects", "write_text", "write_bin", "read_bin"};
+	constexpr size_t PHASES = size(phases);
+
+	for(size_t players: scales) {
+		shape.players = players;
+		mt19937 gen_rng(seed);
+		ostringstream text_os;
+		generate_world(text_os, shape, gen_rng);
+		string text = text_os.str();
+
+		vector<vector<double>> times(PHASES);
+		vector<uint64_t> allocs(PHASES);
+		size_t bindings = 0;
+		auto timed = [&](size_t phase, auto &&f) {
+			uint64_t allocs_before = allocations;
+			auto start = clock::now();
+			f();
+			times[phase].push_back(chrono::duration<double>(clock::now() - start).count());
+			allocs[phase] += allocations - allocs_before;
+		};
+		for(size_t rep = 0; rep < reps; rep++) {
+			World w;
+			timed(0, [&]() {
+				TextReader in(text);
+				w.read(in);
+			});
+			Round r(w, mt19937(seed));
+			r.threads = threads;
+			timed(1, [&]() { r.bind_events(); });
+			timed(2, [&]() { r.render_messages(); });
+			timed(3, [&]() { r.apply_effects(); });
+			bindings = r.bindings.size();
+			ostringstream text_out, bin_out;
+			timed(4, [&]() { text_out << w; });
+			timed(5, [&]() { w.write_binary(bin_out); });
+			string image = bin_out.str();
+			World copy;
+			timed(6, [&]() { copy.read_binary(image); });
+		}
+
+		for(size_t phase = 0; phase < PHASES; phase++) {
+			const auto &ts = times[phase];
+			double best = *min_element(ts.begin(), ts.end());
+			double mean = accumulate(ts.begin(), ts.end(), 0.0) / ts.size();
+			os << "{\"phase\": \"" << phases[phase] << "\"";
+			os << ", \"players\": " << shape.players;
+			os << ", \"events\": " << shape.events;
+			os << ", \"relations\": " << shape.relations;
+			os << ", \"density\": " << shape.density;
+			os << ", \"seed\": " << seed;
+			os << ", \"reps\": " << reps;
+			os << ", \"threads\": " << threads;
+			os << ", \"world_bytes\": " << text.size();
+			os << ", \"bindings\": " << bindings;
+			os << ", \"best_s\": " << best;
+			os << ", \"mean_s\": " << mean;
+			os << ", \"allocs\": " << allocs[phase] / reps;
+			os << "}" << endl;
+		}
+	}
+}
+
+// Removes `--name`, `--name=value` or, when it takes a value, `--name value`
+// from args, and returns the value ("" for a bare flag) if it was present.
+optional<string> take_option(vector<string> &args, const string &name, bool takes_value = false) {
+	for(auto it = args.begin(); it != args.end(); it++) {
+		if(*it == "--" + name) {
+			string value;
+			if(takes_value && it + 1 != args.end()) {
+				value = *(it + 1);
+				args.erase(it, it + 2);
+			} else {
+				args.erase(it);
 			}
-			is.get();
-			string message;
-			getline(is, message, '}');
-			render = Event::render::parse_message(message);
-		} else break;
+			return make_optional(value);
+		}
+		if(it->starts_with("--" + name + "=")) {
+			string value = it->substr(name.size() + 3);
+			args.erase(it);
+			return make_optional(value);
+		}
 	}
+	return optional<string>();
+}
 
-	return is;
+// Writes --stats output to the named file, or stderr if there's no name
+void write_stats(const string &path, const RoundStats &stats) {
+	if(path.empty()) {
+		stats.write_json(cerr);
+		return;
+	}
+	ofstream f(path);
+	if(!f) {
+		cerr << "couldn't open " << path << " for stats" << endl;
+		return;
+	}
+	stats.write_json(f);
 }
 
+// Holds worlds in memory and answers commands about them, a line each, on
+// a Unix socket, so that clients needn't pipe a world through a fresh
+// process every time. Each reply is a line `ok` or `error`, then the
+// output (or what went wrong), then a line `.`; output lines that begin
+// with `.` get another one in front, which clients should take off.
+class Server {
+	public:
+		size_t threads = 1;
+		bool binary = false;  // for snapshots written to files
+
+		// Loads (or reloads) the world in path as name, and makes it the
+		// one new clients use
+		bool load(const string &name, const string &path) {
+			auto held = make_unique<Held>();
+			ifstream f(path);
+			int fd = open(path.c_str(), O_RDONLY);
+			if(fd < 0) {
+				cerr << "couldn't open " << path << endl;
+				return false;
+			}
+			bool ok = read_world(held->world, f, fd);
+			close(fd);
+			if(!ok) return false;
+			held->rng.seed(random_device()());
+			worlds[name] = move(held);
+			if(!worlds.contains(default_world)) default_world = name;
+			return true;
+		}
+
+		// Serves clients on the socket at path until one says shutdown
+		bool serve(const string &path) {
+			int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+			sockaddr_un addr{};
+			addr.sun_family = AF_UNIX;
+			if(listener < 0 || path.size() >= sizeof(addr.sun_path)) {
+				cerr << "can't make a socket at " << path << endl;
+				return false;
+			}
+			strcpy(addr.sun_path, path.c_str());
+			// A socket left behind by an earlier server is replaced
+			struct stat st;
+			if(stat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) unlink(path.c_str());
+			if(bind(listener, (sockaddr *) &addr, sizeof(addr)) != 0 || listen(listener, 16) != 0) {
+				cerr << "can't listen on " << path << ": " << strerror(errno) << endl;
+				close(listener);
+				return false;
+			}
+
+			while(!stopping) {
+				vector<pollfd> fds{{listener, POLLIN, 0}};
+				for(const Client &c: clients) fds.push_back({c.fd, POLLIN, 0});
+				if(poll(fds.data(), fds.size(), -1) < 0) {
+					if(errno == EINTR) continue;
+					break;
+				}
+				if(fds[0].revents & POLLIN) {
+					int fd = accept(listener, nullptr, nullptr);
+					if(fd >= 0) clients.push_back({.fd = fd, .world = default_world});
+				}
+				for(size_t i = 1; i < fds.size(); i++) {
+					if(fds[i].revents) receive(clients[i - 1]);
+				}
+				erase_if(clients, [](const Client &c) { return c.fd < 0; });
+			}
+
+			for(Client &c: clients) close(c.fd);
+			close(listener);
+			unlink(path.c_str());
+			return true;
+		}
+
+	private:
+		// A world and the changes made to it since it was loaded: by each
+		// round, and by try_event before the first round and after each
+		class Held {
+			public:
+				World world;
+				vector<ChangeLog> rounds;
+				vector<ChangeLog> by_hand{1};  // one more than rounds
+				mt19937 rng;
+		};
+
+		class Client {
+			public:
+				int fd;
+				string world;  // the name of the one it uses
+				string pending{};  // what's been read past the last whole line
+		};
+
+		map<string, unique_ptr<Held>> worlds;
+		string default_world;
+		vector<Client> clients;
+		bool stopping = false;
+
+		void receive(Client &c) {
+			char buf[4096];
+			ssize_t n = read(c.fd, buf, sizeof(buf));
+			if(n <= 0) {
+				close(c.fd);
+				c.fd = -1;
+				return;
+			}
+			c.pending.append(buf, n);
+			size_t start = 0;
+			for(size_t end; c.fd >= 0 && (end = c.pending.find('\n', start)) != string::npos; start = end + 1) {
+				string_view line(c.pending.data() + start, end - start);
+				if(line.ends_with('\r')) line.remove_suffix(1);
+				reply(c, line);
+			}
+			c.pending.erase(0, start);
+		}
+
+		void reply(Client &c, string_view line) {
+			// Everything that reports errors does it on cerr, so a
+			// command's errors are caught there and sent back
+			ostringstream out, err;
+			streambuf *real_cerr = cerr.rdbuf(err.rdbuf());
+			bool ok = command(c, line, out);
+			cerr.rdbuf(real_cerr);
+			if(c.fd < 0) return;
+
+			string text = ok ? out.str() : err.str();
+			if(ok) cerr << err.str();  // warnings stay with the server
+			string framed = ok ? "ok\n" : "error\n";
+			istringstream lines(text);
+			for(string l; getline(lines, l); ) {
+				if(l.starts_with('.')) framed += '.';
+				framed += l;
+				framed += '\n';
+			}
+			framed += ".\n";
+			for(size_t at = 0; at < framed.size(); ) {
+				ssize_t n = send(c.fd, framed.data() + at, framed.size() - at, MSG_NOSIGNAL);
+				if(n <= 0) {
+					close(c.fd);
+					c.fd = -1;
+					return;
+				}
+				at += n;
+			}
+		}
+
+		bool command(Client &c, string_view line, ostream &out) {
+			TextReader in(line);
+			string name(in.word());
+			vector<string> words;
+			for(string_view word; !(word = in.word()).empty(); ) words.emplace_back(word);
+
+			if(name == "quit") {
+				close(c.fd);
+				c.fd = -1;
+				return true;
+			}
+			if(name == "shutdown") {
+				stopping = true;
+				return true;
+			}
+			if(name == "worlds") {
+				for(const auto &[id, held]: worlds) {
+					out << id << " " << held->rounds.size() << " " << held->world.players.size();
+					out << (id == c.world ? " *" : "") << endl;
+				}
+				return true;
+			}
+			if(name == "load") {
+				if(words.size() != 2) {
+					cerr << "usage: load <name> <file>" << endl;
+					return false;
+				}
+				if(!load(words[0], words[1])) return false;
+				c.world = words[0];
+				return true;
+			}
+			if(name == "use") {
+				if(words.size() != 1 || !worlds.contains(words[0])) {
+					cerr << "usage: use <name>, for a world that has been loaded" << endl;
+					return false;
+				}
+				c.world = words[0];
+				return true;
+			}
+
+			auto it = worlds.find(c.world);
+			if(it == worlds.end()) {
+				cerr << "no world loaded; use load <name> <file>" << endl;
+				return false;
+			}
+			Held &held = *it->second;
+			World &w = held.world;
+
+			if(name == "round") {
+				ChangeLog &changes = held.rounds.emplace_back();
+				held.by_hand.emplace_back();
+				Round r(w, mt19937(held.rng()));
+				r.changes = &changes;
+				r.threads = threads;
+				r.resolve();
+				out << r;
+				return true;
+			}
+			if(name == "list") {
+				if(words.empty() || words[0] != "players") {
+					cerr << "usage: list players [<filter>]" << endl;
+					return false;
+				}
+				// The filter is the rest of the line, spaces and all
+				TextReader rest(line);
+				rest.word();
+				rest.word();
+				optional<string> spec;
+				if(string_view filter = TextReader::trim(rest.line()); !filter.empty()) spec = string(filter);
+				return list_players(out, w, spec);
+			}
+			if(name == "try_event") {
+				if(words.empty()) {
+					cerr << "usage: try_event <event> <needid>:<playerid>..." << endl;
+					return false;
+				}
+				optional<Event::Binding> binding = bind_by_hand(w, words[0], span(words).subspan(1));
+				if(!binding) return false;
+				binding->cause_effects(w, &held.by_hand.back());
+				out << *binding << endl;
+				return true;
+			}
+			if(name == "diff-since") {
+				size_t since = 0;
+				if(!words.empty() && from_chars(words[0].data(), words[0].data() + words[0].size(), since).ec != errc()) {
+					cerr << "usage: diff-since <round>" << endl;
+					return false;
+				}
+				if(since > held.rounds.size()) {
+					cerr << "only " << held.rounds.size() << " rounds have been played" << endl;
+					return false;
+				}
+				ChangeLog changes;
+				for(size_t i = since; i < held.rounds.size(); i++) {
+					changes.merge(held.by_hand[i]);
+					changes.merge(held.rounds[i]);
+				}
+				changes.merge(held.by_hand.back());
+				changes.write(out, w);
+				return true;
+			}
+			if(name == "snapshot") {
+				if(words.empty()) {
+					out << w;
+					return true;
+				}
+				ofstream f(words[0]);
+				if(!f) {
+					cerr << "couldn't open " << words[0] << " for the snapshot" << endl;
+					return false;
+				}
+				write_world(f, w, binary);
+				return true;
+			}
+			cerr << "unknown command " << name << "--I know worlds, load, use, round, list, try_event, diff-since, snapshot, quit and shutdown" << endl;
+			return false;
+		}
+};
+
 void usage() {
-	cerr << "I know the following arguments (no options yet!):" << endl;
+	cerr << "I know the following arguments:" << endl;
 	cerr << " - cat -- just output the world that was input. useful for testing and validation" << endl;
 	cerr << " - list players [spec] -- list all players, or the ones matching the actorspec (like in an event)" << endl;
 	cerr << " - try_events -- try every event in the set (to be sure they print), as long as enough players exist" << endl;
 	cerr << " - try_event <event> <needid>:<playerid>... -- print out an event with manually-specified bindings" << endl;
 	cerr << " - diff <newworld> -- compares the (old) world that was input to the new world in the named file" << endl;
 	cerr << " - round -- run a round of simulation generating logs" << endl;
+	cerr << " - tournament <filter> [winners] -- run rounds until at most winners (default 1) players match filter, printing messages and diffs" << endl;
+	cerr << " - simulate [--runs N] [--threads T] [--seed S] [--max-rounds R] <filter> [winners] -- play many tournaments in parallel and report win rates, lengths and event counts" << endl;
+	cerr << " - gen [--players N] [--events M] [--relations R] [--density D] [--seed S] -- write a random world of that size" << endl;
+	cerr << " - bench [--players N,...] [--events M] [--relations R] [--density D] [--seed S] [--reps K] [--threads T] -- time each phase of a round on generated worlds, as JSON lines" << endl;
+	cerr << " - replay <journal> [round] -- write the world a journal records after round (default: the last)" << endl;
+	cerr << " - serve <socket> [[name=]file...] -- hold worlds in memory and answer commands (round, list, try_event, diff-since, snapshot...) on a Unix socket" << endl;
+	cerr << " (gen, bench, replay and serve don't read a world from input)" << endl;
+	cerr << "and the following options:" << endl;
+	cerr << " --format=text|bin -- the format of worlds written (by cat, try_event and round); either format is accepted as input" << endl;
+	cerr << " --stats[=<file>] -- have round, tournament and simulate write counters for each event and time spent in each phase, as JSON, to stderr or file" << endl;
+	cerr << " --messages=<file> -- have round write its messages to file as they happen instead of after the world; - means stdout, before the world" << endl;
+	cerr << " --diff -- have round print its changes to the world, as diff would, after its messages" << endl;
+	cerr << " --journal=<file> -- have round and tournament append each round's changes to a journal; round continues from a journal that has content" << endl;
+	cerr << " --threads=<n> -- have round, tournament and bench render messages and apply effects on n threads, once a round's events are bound" << endl;
 }
 
 int main(int argc, char **argv) {
@@ -1510,62 +4343,146 @@ int main(int argc, char **argv) {
 		return 1;
 	}
 
+	bool binary = false;
+	if(optional<string> format = take_option(args, "format")) {
+		if(*format == "bin") {
+			binary = true;
+		} else if(*format != "text") {
+			cerr << "unknown format " << *format << "--I know text and bin" << endl;
+			return 1;
+		}
+	}
+
+	optional<string> messages_path = take_option(args, "messages");
+	optional<string> stats_path = take_option(args, "stats");
+	optional<string> journal_path = take_option(args, "journal");
+	bool show_diff = take_option(args, "diff").has_value();
+	optional<string> threads_opt = take_option(args, "threads", true);
+	size_t threads = threads_opt ? max(stoul(*threads_opt), 1ul) : 1;
+	RoundStats stats;
+
+	if(args.size() < 2) {
+		usage();
+		return 1;
+	}
+
 	string action = args.at(1);
 
-	World w;
-	cin >> w;
+	// These make their own worlds rather than reading one
+	if(action == "gen" || action == "bench") {
+		WorldShape shape;
+		optional<string> players = take_option(args, "players", true);
+		if(optional<string> events = take_option(args, "events", true)) shape.events = stoul(*events);
+		if(optional<string> relations = take_option(args, "relations", true)) shape.relations = stoul(*relations);
+		if(optional<string> density = take_option(args, "density", true)) shape.density = stod(*density);
+		optional<string> seed_opt = take_option(args, "seed", true);
+		uint32_t seed = seed_opt ? stoul(*seed_opt) : 1;
+
+		if(action == "gen") {
+			if(players) shape.players = stoul(*players);
+			mt19937 rng(seed);
+			generate_world(cout, shape, rng);
+		} else {
+			vector<size_t> scales = {100, 1000, 10000};
+			if(players) {
+				scales.clear();
+				istringstream ss(*players);
+				string n;
+				while(getline(ss, n, ',')) scales.push_back(stoul(n));
+			}
+			optional<string> reps = take_option(args, "reps", true);
+			run_bench(cout, shape, scales, reps ? max(stoul(*reps), 1ul) : 3, seed, threads);
+		}
+		return 0;
+	}
 
-	if(action == "cat") {
-		cout << w;
-	} else if(action == "try_event") {
+	if(action == "serve") {
 		if(args.size() < 3) {
-			cerr << "try_event <event> <needid>:<playerid>..." << endl;
+			cerr << "usage: serve <socket> [[<name>=]<file>...]" << endl;
 			return 1;
 		}
-		string evid = args.at(2);
-		if(!w.events.forward.contains(evid)) {
-			cerr << "no event named " << evid << "; the events are [";
-			write_joined(cerr, w.events.forward.begin(), w.events.forward.end(), [](const auto &pair) {
-					return pair.first;
-			});
-			cerr << "]" << endl;
+		if(journal_path || stats_path || show_diff || messages_path) {
+			cerr << "serve only takes --format and --threads; its rounds' changes are read back with diff-since" << endl;
 			return 1;
 		}
-		Event &ev = w.events.forward.at(evid);
-		if(args.size() - 3 != ev.involved_actors()) {
-			cerr << "event expects " << ev.involved_actors() << " actors; you supplied " << (args.size() - 3) << endl;
+		Server server;
+		server.threads = threads;
+		server.binary = binary;
+		for(auto it = args.begin() + 3; it != args.end(); it++) {
+			size_t eq = it->find('=');
+			string name = eq == string::npos ? *it : it->substr(0, eq);
+			string path = eq == string::npos ? *it : it->substr(eq + 1);
+			if(!server.load(name, path)) return 1;
+		}
+		return server.serve(args.at(2)) ? 0 : 1;
+	}
+
+	if(action == "replay") {
+		if(args.size() < 3) {
+			cerr << "usage: replay <journal> [<round>]" << endl;
 			return 1;
 		}
-		map<string, Player *> bindings;
-		for(auto it = args.begin() + 3; it != args.end(); it++) {
-			auto pos = it->find(':');
-			if(pos == string::npos) {
-				cerr << "needid:playerid spec " << *it << " is invalid--need a colon" << endl;
-				return 1;
-			}
-			string needid = it->substr(0, pos);
-			string playerid = it->substr(pos + 1);
-			if(!ev.actors.forward.contains(needid)) {
-				cerr << "event does not contain a needid " << needid << endl;
-				return 1;
-			}
-			if(!w.players.forward.contains(playerid)) {
-				cerr << "no such playerid " << playerid << endl;
-				return 1;
-			}
-			bindings.insert_or_assign(needid, &w.players.forward.at(playerid));
+		optional<size_t> upto;
+		if(args.size() >= 4) upto = stoul(args.at(3));
+		World w;
+		optional<size_t> last = load_journal(w, args.at(2), upto);
+		if(!last) return 1;
+		if(upto && *last < *upto) {
+			cerr << "the journal only goes up to round " << *last << endl;
+			return 1;
+		}
+		write_world(cout, w, binary);
+		return 0;
+	}
+
+	World w;
+	if(journal_path && action != "round" && action != "tournament") {
+		cerr << "--journal only applies to round and tournament" << endl;
+		return 1;
+	}
+	// With an existing journal, play picks up where the journal left off;
+	// a checkpoint is only ever written to an empty one
+	optional<size_t> journal_round;
+	struct stat journal_st;
+	if(journal_path && stat(journal_path->c_str(), &journal_st) == 0 && journal_st.st_size > 0) {
+		journal_round = load_journal(w, *journal_path);
+		if(!journal_round) return 1;
+	} else if(!read_world(w, cin, STDIN_FILENO)) {
+		return 1;
+	}
+	ofstream journal;
+	if(journal_path) {
+		journal.open(*journal_path, ios::app);
+		if(!journal) {
+			cerr << "couldn't open journal " << *journal_path << endl;
+			return 1;
+		}
+		// The checkpoint the rounds' changes apply to
+		if(!journal_round) journal << w << "---" << endl;
+	}
+
+	if(action == "cat") {
+		write_world(cout, w, binary);
+	} else if(action == "try_event") {
+		if(args.size() < 3) {
+			cerr << "try_event <event> <needid>:<playerid>..." << endl;
+			return 1;
 		}
-		auto binding = Event::Binding(ev, bindings);
-		binding.cause_effects(w);
-		cout << w << "---" << endl << binding << endl;
+		optional<Event::Binding> binding = bind_by_hand(w, args.at(2), span(args).subspan(3));
+		if(!binding) return 1;
+		binding->cause_effects(w);
+		write_world(cout, w, binary);
+		cout << "---" << endl << *binding << endl;
 	} else if(action == "try_events") { 
 		vector<Player *> players;
 		players.reserve(w.players.size());
-		for(auto &[_, ply]: w.players.forward) players.push_back(&ply);
+		for(auto &[_, ply]: w.players.by_name()) players.push_back(&ply);
+		PlayerPool pool;
+		pool.assign(players, w.roster);
 
-		for(const auto &[evname, event]: w.events.forward) {
-			vector<Player *> list(players);
-			optional<Event::Binding> b = Event::Binding::try_bind(event, w, list, false);
+		for(const auto &[evname, event]: w.events.by_name()) {
+			optional<Event::Binding> b = Event::Binding::try_bind(event, w, pool, false);
+			pool.rollback();
 			if(!b) {
 				cerr << "Failed to bind for event " << evname << "; maybe there aren't enough players?" << endl;
 			} else {
@@ -1579,12 +4496,15 @@ int main(int argc, char **argv) {
 		}
 		World nw;
 		ifstream f(args.at(2));
-		f >> nw;
+		int fd = open(args.at(2).c_str(), O_RDONLY);
+		bool ok = read_world(nw, f, fd);
+		if(fd >= 0) close(fd);
+		if(!ok) return 1;
 		set<string> oldkeys, newkeys, addkeys, remkeys, samekeys;
-		for(const auto &[id, _]: w.players.forward)
+		for(const auto &[id, _]: w.players.by_name())
 
 			oldkeys.insert(id);
-		for(const auto &[id, _]: nw.players.forward)
+		for(const auto &[id, _]: nw.players.by_name())
 			newkeys.insert(id);
 		asym_diff(oldkeys, newkeys, addkeys, remkeys, samekeys);
 		for(const string &removed: remkeys)
@@ -1596,9 +4516,9 @@ int main(int argc, char **argv) {
 
 		oldkeys.clear();
 		newkeys.clear();
-		for(const auto &[id, _]: w.relations.forward)
+		for(const auto &[id, _]: w.relations.by_name())
 			oldkeys.insert(id);
-		for(const auto &[id, _]: nw.relations.forward)
+		for(const auto &[id, _]: nw.relations.by_name())
 			newkeys.insert(id);
 		asym_diff(oldkeys, newkeys, addkeys, remkeys, samekeys);
 		for(const string &removed: remkeys)
@@ -1613,28 +4533,199 @@ int main(int argc, char **argv) {
 			return 1;
 		}
 		if(args.at(2) == "players") {
-			optional<Event::ActorSpec> filter;
-			if(args.size() >= 4) {
-				Event::ActorSpec as;
-				istringstream ss(args.at(3));
-				ss >> as;
-				filter = as;
-			}
-			for(const auto &[id, ply]: w.players.forward) {
-				if(filter.has_value() && !filter->applies_to(&ply)) continue;
-				cout << id << " " << ply.name << endl;
-			}
+			optional<string> spec;
+			if(args.size() >= 4) spec = args.at(3);
+			if(!list_players(cout, w, spec)) return 1;
 		} else {
 			cerr << "unknown entity type " << args.at(2) << "--I know about players" << endl;
 		}
 	} else if(action == "round") {
 		random_device rd;
 		Round r(w, mt19937(rd()));
-		r.resolve();
-		cout << w << endl;
-		cout << "---" << endl;
-		cout << r << endl;
+		if(stats_path) r.stats = &stats;
+		r.threads = threads;
+		ChangeLog changes;
+		if(journal_path || show_diff) r.changes = &changes;
+		// The changes, as diff would print them, after the messages
+		auto write_diff = [&](ostream &os) {
+			if(!show_diff) return;
+			os << endl;
+			changes.write(os, w, false);
+		};
+		if(journal_path) {
+			// The journal keeps the world, so only messages are printed
+			r.message_sink = &cout;
+			r.resolve();
+			write_diff(cout);
+			journal << "@round " << journal_round.value_or(0) + 1 << endl;
+			changes.write(journal, w);
+		} else if(!messages_path) {
+			r.resolve();
+			write_world(cout, w, binary);
+			cout << endl;
+			cout << "---" << endl;
+			cout << r << endl;
+			write_diff(cout);
+		} else if(*messages_path == "-") {
+			// messages first, as they happen; the world follows
+			r.message_sink = &cout;
+			r.resolve();
+			write_diff(cout);
+			cout << "---" << endl;
+			write_world(cout, w, binary);
+		} else {
+			ofstream messages(*messages_path);
+			if(!messages) {
+				cerr << "couldn't open " << *messages_path << " for messages" << endl;
+				return 1;
+			}
+			r.message_sink = &messages;
+			r.resolve();
+			write_diff(messages);
+			write_world(cout, w, binary);
+		}
+	} else if(action == "tournament") {
+		if(args.size() < 3) {
+			cerr << "usage: tournament <filter> [<winners>]" << endl;
+			return 1;
+		}
+		size_t winners = 1;  // there can be only one
+		if(args.size() >= 4) winners = stoul(args.at(3));
+
+		random_device rd;
+		unique_ptr<Game> game = Game::start(w, args.at(2), winners, mt19937(rd()));
+		if(!game) return 1;
+		game->log = &cout;
+		game->threads = threads;
+		game->rounds = journal_round.value_or(0);
+		if(journal_path) game->journal = &journal;
+		if(stats_path) game->stats = &stats;
+		auto remaining = game->play();
+		cout << "The tournament is over; the winners are:" << endl;
+		for(const auto &[id, ply]: remaining)
+			cout << id << " " << ply->name << endl;
+	} else if(action == "simulate") {
+		optional<string> runs_opt = take_option(args, "runs", true);
+		optional<string> seed_opt = take_option(args, "seed", true);
+		optional<string> max_rounds_opt = take_option(args, "max-rounds", true);
+		if(args.size() < 3) {
+			cerr << "usage: simulate [--runs N] [--threads T] [--seed S] [--max-rounds R] <filter> [<winners>]" << endl;
+			return 1;
+		}
+		size_t runs = runs_opt ? stoul(*runs_opt) : 100;
+		if(!threads_opt) threads = max(thread::hardware_concurrency(), 1u);
+		uint32_t seed;
+		if(seed_opt) {
+			seed = stoul(*seed_opt);
+		} else {
+			random_device rd;
+			seed = rd();
+		}
+		size_t max_rounds = max_rounds_opt ? stoul(*max_rounds_opt) : 1000;
+		string filter_spec = args.at(2);
+		size_t winners = 1;
+		if(args.size() >= 4) winners = stoul(args.at(3));
+
+		// Every run starts from its own copy of this snapshot
+		ostringstream image_os;
+		w.write_binary(image_os);
+		string image = image_os.str();
+
+		struct Outcome {
+			vector<string> winners;
+			size_t rounds = 0;
+			bool finished = false;
+			map<string, size_t> fired;
+			RoundStats stats;
+		};
+		vector<Outcome> outcomes(runs);
+		// Each run's stream depends only on the seed and run number, so
+		// results don't depend on the number of threads.
+		auto start = [&](size_t run, World &copy) {
+			seed_seq seq{seed, uint32_t(run)};
+			return Game::start(copy, filter_spec, winners, mt19937(seq));
+		};
+		auto play = [&](size_t run, World &copy, Game &game) {
+			game.max_rounds = max_rounds;
+			Outcome &out = outcomes[run];
+			if(stats_path) game.stats = &out.stats;
+			for(const auto &[id, _]: game.play())
+				out.winners.push_back(id);
+			out.rounds = game.rounds;
+			out.finished = game.finished();
+			for(const auto &[ev, count]: game.fired)
+				out.fired[copy.events.get_name(ev)] += count;
+		};
+		atomic<size_t> next_run = 1;
+		auto worker = [&]() {
+			for(size_t run; (run = next_run++) < runs; ) {
+				World copy;
+				copy.read_binary(image);
+				if(unique_ptr<Game> game = start(run, copy)) play(run, copy, *game);
+			}
+		};
+
+		// The first run is set up here, so a bad filter is reported once
+		// and before any thread starts; this thread then plays it
+		World first;
+		first.read_binary(image);
+		unique_ptr<Game> first_game = start(0, first);
+		if(!first_game) return 1;
+		vector<thread> pool;
+		for(size_t i = 1; i < min(threads, runs); i++)
+			pool.emplace_back(worker);
+		if(runs > 0) play(0, first, *first_game);
+		worker();
+		for(auto &t: pool)
+			t.join();
+
+		size_t finished = 0;
+		map<string, size_t> player_wins, attr_wins, fired;
+		map<size_t, size_t> rounds;
+		for(const auto &out: outcomes) {
+			stats.merge(out.stats);
+			if(!out.finished) continue;
+			finished++;
+			rounds[out.rounds]++;
+			for(const string &id: out.winners) {
+				player_wins[id]++;
+				for(const string &attr: w.players.get(id)->attrs)
+					attr_wins[attr]++;
+			}
+			for(const auto &[ev, count]: out.fired)
+				fired[ev] += count;
+		}
+
+		auto by_count = [](const map<string, size_t> &counts) {
+			vector<pair<string, size_t>> sorted(counts.begin(), counts.end());
+			stable_sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) {
+					return a.second > b.second;
+			});
+			return sorted;
+		};
+		auto percent = [&](size_t n) {
+			ostringstream os;
+			os << fixed << setprecision(1) << (finished ? 100.0 * n / finished : 0.0) << "%";
+			return os.str();
+		};
+
+		cout << runs << " runs from seed " << seed << ": " << finished << " finished, ";
+		cout << runs - finished << " stopped after " << max_rounds << " rounds" << endl;
+		cout << endl << "wins by player:" << endl;
+		for(const auto &[id, count]: by_count(player_wins))
+			cout << "  " << count << " " << percent(count) << " " << id << " " << w.players.get(id)->name << endl;
+		cout << endl << "wins by attribute (held at the start):" << endl;
+		for(const auto &[attr, count]: by_count(attr_wins))
+			cout << "  " << count << " " << percent(count) << " " << attr << endl;
+		cout << endl << "rounds to finish:" << endl;
+		for(const auto &[n, count]: rounds)
+			cout << "  " << n << ": " << count << endl;
+		cout << endl << "events fired (per finished run):" << endl;
+		for(const auto &[ev, count]: by_count(fired))
+			cout << "  " << count << " " << fixed << setprecision(2) << (finished ? double(count) / finished : 0.0) << " " << ev << endl;
 	}
 
+	if(stats_path) write_stats(*stats_path, stats);
+
 	return 0;
 }
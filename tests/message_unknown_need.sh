@@ -0,0 +1,20 @@
+#!/bin/bash
+# A message ref to a need the event doesn't have (or a bare trailing $) is
+# warned about and printed as written, rather than failing the load.
+dtes="${DTES:-./dtes}"
+
+diff -u - <($dtes try_events 2>&1 <<'WORLD'
+pronouns { m: he him his himself sing }
+players { p: P(m)[] }
+events {
+	meet: { needs { a: [] } message {$a meets $b; <(c)s> wave[(c)sing=s].} }
+	price: { needs { a: [] } message {$a pays 5$} }
+}
+WORLD
+) <<'EXPECTED'
+event meet: message names no need b; (it's printed as written)
+event meet: message names no need c (it's printed as written)
+event price: message names no need  (it's printed as written)
+P meets $b; <(c)s> wave[(c)sing=s].
+P pays 5$
+EXPECTED
@@ -0,0 +1,17 @@
+#!/bin/bash
+# try_events on a world with fewer players than an event needs: that event
+# is reported as unbindable and the others still print.
+dtes="${DTES:-./dtes}"
+
+diff -u - <($dtes try_events 2>&1 <<'WORLD'
+pronouns { m: he him his himself sing }
+players { p: P(m)[] }
+events {
+	pair: { needs { a: [] b: [] } message {$a meets $b.} }
+	solo: { needs { a: [] } message {$a waits.} }
+}
+WORLD
+) <<'EXPECTED'
+Failed to bind for event pair; maybe there aren't enough players?
+P waits.
+EXPECTED